@@ -0,0 +1,43 @@
+# Building scripts translated by '--emit-cpp' against sapphire-runtime.
+#
+#   sapphire_add_native_script(<name> SCRIPT <file> [SHARED])
+#
+# Executable <name> is built by default. With SHARED, a shared object
+# exporting 'int sapphire_native_main(int argc, char **argv)' is built
+# instead. Translated script is written to <name>.cc of current binary dir.
+#
+# Translation only removes dispatch between commands: every command is
+# still executed by the handler of interpreter, nothing is specialized by
+# operand types, and calling/returning is done by interpreter loop. Don't
+# expect more than the saving of instruction fetching and decoding.
+#
+# Script path is recorded relative to <name>.cc and resolved against the
+# directory of the binary at startup, so binary is expected to be next to
+# translated source, with the script at the same relative location.
+function(sapphire_add_native_script name)
+  cmake_parse_arguments(NATIVE "SHARED" "SCRIPT" "" ${ARGN})
+
+  if (NOT NATIVE_SCRIPT)
+    message(FATAL_ERROR "sapphire_add_native_script: SCRIPT is required")
+  endif()
+
+  get_filename_component(script_path ${NATIVE_SCRIPT} ABSOLUTE)
+  set(output ${CMAKE_CURRENT_BINARY_DIR}/${name}.cc)
+
+  add_custom_command(
+    OUTPUT ${output}
+    COMMAND $<TARGET_FILE:sapphire-adhoc> --script=${script_path} --emit-cpp=${output}
+      --log=${CMAKE_CURRENT_BINARY_DIR}/${name}-emit.log
+    WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+    DEPENDS ${script_path} sapphire-adhoc
+    COMMENT "Translating ${NATIVE_SCRIPT}")
+
+  if (NATIVE_SHARED)
+    add_library(${name} SHARED ${output})
+  else()
+    add_executable(${name} ${output})
+    target_compile_definitions(${name} PRIVATE SAPPHIRE_NATIVE_MAIN)
+  endif()
+
+  target_link_libraries(${name} sapphire-runtime)
+endfunction()
@@ -17,4 +17,19 @@ namespace sapphire {
 
     return found;
   }
+
+  // index_map[idx] is new index of first remaining node at or after idx
+  void AnnotatedAST::RebaseJumpRecords(const vector<size_t> &index_map) {
+    unordered_map<size_t, list<size_t>> rebased;
+
+    for (auto &unit : jump_record_) {
+      list<size_t> record;
+
+      for (auto target : unit.second) record.push_back(index_map[target]);
+
+      rebased.emplace(index_map[unit.first], record);
+    }
+
+    jump_record_.swap(rebased);
+  }
 }
\ No newline at end of file
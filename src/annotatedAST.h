@@ -32,6 +32,7 @@ namespace sapphire {
     bool local_object;
     bool ext_object;
     bool use_last_assert;
+    bool tail_call;
     size_t nest;
     size_t nest_end;
     size_t escape_depth;
@@ -43,6 +44,7 @@ namespace sapphire {
       local_object(false), 
       ext_object(false),
       use_last_assert(false),
+      tail_call(false),
       nest(0),
       nest_end(0),
       escape_depth(0),
@@ -146,7 +148,9 @@ namespace sapphire {
       jump_record_.emplace(make_pair(index, record));
     }
 
+    const auto &GetJumpRecords() const { return jump_record_; }
     bool FindJumpRecord(size_t index, stack<size_t> &dest);
+    void RebaseJumpRecords(const vector<size_t> &index_map);
   };
 
   using AASTPointer = AnnotatedAST * ;
@@ -0,0 +1,479 @@
+#include "bytecode.h"
+#include "management.h"
+
+namespace sapphire {
+  FetchKind GetFetchKind(Argument &arg) {
+    auto &properties = arg.properties;
+    FetchKind kind = FetchKind::Invalid;
+
+    switch (arg.GetType()) {
+    case ArgumentType::Literal:
+      kind = FetchKind::Literal;
+      break;
+    case ArgumentType::Pool:
+      if (properties.member_access.use_last_assert) {
+        kind = FetchKind::LastAssert;
+      }
+      else if (!properties.domain.id.empty()) {
+        switch (properties.domain.type) {
+        case ArgumentType::Pool: kind = FetchKind::Member; break;
+        case ArgumentType::RetStack: kind = FetchKind::ChainMember; break;
+        default: kind = FetchKind::Unresolved; break;
+        }
+      }
+      else {
+        kind = FetchKind::Named;
+      }
+      break;
+    case ArgumentType::RetStack:
+      kind = FetchKind::RetStack;
+      break;
+    default:
+      break;
+    }
+
+    return kind;
+  }
+
+  bool MaterializeLiteral(Argument &arg, Object &dest) {
+    auto &value = arg.GetData();
+
+    switch (arg.GetStringType()) {
+    case LiteralType::Int: {
+      int64_t int_value = 0;
+      auto *begin = value.data() + (!value.empty() && value.front() == '+' ? 1 : 0);
+      auto result = from_chars(begin, value.data() + value.size(), int_value);
+      if (result.ec != std::errc() || result.ptr != value.data() + value.size()) return false;
+      dest = Object(int_value, kTypeHandleInt);
+      break;
+    }
+    case LiteralType::Float: {
+      double float_value = 0.0;
+#ifndef _MSC_VER
+      //dealing with issues of charconv implementation in low-version clang
+      float_value = stod(value);
+#else
+      from_chars(value.data(), value.data() + value.size(), float_value);
+#endif
+      dest = Object(float_value, kTypeHandleFloat);
+      break;
+    }
+    case LiteralType::Bool:
+      dest = Object(value == kStrTrue, kTypeHandleBool);
+      break;
+    case LiteralType::String:
+      dest = Object(lexical::IsString(value) ? lexical::GetRawString(value) : value);
+      break;
+      //for binding expression
+    case LiteralType::Identifier:
+      dest = Object(value);
+      break;
+    default:
+      return false;
+    }
+
+    return true;
+  }
+
+  MethodCacheEntry &CallSite::GetMethodCache(TypeHandle type) {
+    for (auto &unit : methods) {
+      if (unit.type == type) return unit;
+    }
+
+    if (methods.size() < kMethodCacheSize) {
+      methods.emplace_back(MethodCacheEntry(type, TryAppendTokenId(GetTypeName(type))));
+      return methods.back();
+    }
+
+    //megamorphic call site, recycle entries in turn
+    auto &victim = methods[next_victim];
+    victim = MethodCacheEntry(type, TryAppendTokenId(GetTypeName(type)));
+    next_victim = (next_victim + 1) % kMethodCacheSize;
+    return victim;
+  }
+
+  // Every identifier gets a fixed slot index inside this code block.
+  // Binding targets are kept apart from plain identifiers because they are
+  // resolved without token id.
+  void Bytecode::AssignSlots() {
+    unordered_map<string, size_t> named, binding, domains;
+    unordered_map<string, size_t> tokens;
+    auto &layout = *slots_;
+
+    auto assign = [&](unordered_map<string, size_t> &dest, Operand &arg, const string &id) -> void {
+      auto result = dest.try_emplace(id, layout.count);
+      if (result.second) layout.count += 1;
+      arg.slot = result.first->second;
+      if (arg.properties.token_id != 0) tokens.try_emplace(id, arg.properties.token_id);
+    };
+
+    for (auto &inst : instructions_) {
+      auto args = GetArguments(inst);
+      bool binding_stmt = compare(inst.operation, Operation::Bind, Operation::Delivering);
+
+      for (size_t idx = 0; idx < args.size(); idx += 1) {
+        auto &arg = args[idx];
+
+        if (arg.fetch == FetchKind::Named) {
+          assign(named, arg, arg.GetData());
+        }
+        else if (arg.fetch == FetchKind::Member) {
+          //slot of domain object, member is found by shape cache
+          assign(domains, arg, arg.properties.domain.id);
+        }
+        else if (binding_stmt && idx == 0 && arg.fetch == FetchKind::Literal &&
+          arg.GetStringType() == LiteralType::Identifier) {
+          assign(binding, arg, arg.GetData());
+        }
+      }
+
+      if (inst.type == NodeType::Function) {
+        auto &domain = call_sites_[inst.call_site].domain;
+        if (domain.fetch == FetchKind::Named) assign(named, domain, domain.GetData());
+      }
+    }
+
+    auto group_of = [&](const string &id) -> SlotGroup {
+      SlotGroup group;
+      if (auto it = named.find(id); it != named.end()) group.named = it->second;
+      if (auto it = domains.find(id); it != domains.end()) group.domain = it->second;
+      return group;
+    };
+
+    for (auto &unit : tokens) layout.tokens.emplace(unit.second, group_of(unit.first));
+    for (auto &unit : binding) layout.links.emplace(unit.second, group_of(unit.first));
+  }
+
+  // Literals are materialized once per script, same literal text shares one
+  // entry. Exported constants take precedence over literal text as they do
+  // in FetchLiteralObject(), identifiers are bound to them directly.
+  void Bytecode::BindConstants() {
+    unordered_map<string, ObjectPointer> literals;
+
+    auto bind = [&](Operand &arg) -> void {
+      if (arg.fetch == FetchKind::Literal) {
+        auto it = literals.find(arg.GetData());
+
+        if (it == literals.end()) {
+          Object obj;
+          ObjectPointer ptr = constant::GetConstantObject(arg.GetData());
+
+          if (ptr == nullptr) {
+            if (!MaterializeLiteral(arg, obj)) return;
+            constants_->emplace_back(std::move(obj));
+            ptr = &constants_->back();
+          }
+
+          it = literals.emplace(arg.GetData(), ptr).first;
+        }
+
+        arg.constant = it->second;
+      }
+      else if (arg.fetch == FetchKind::Named) {
+        arg.constant = constant::GetConstantObject(arg.GetData());
+      }
+    };
+
+    for (auto &unit : operands_) bind(unit);
+    for (auto &unit : call_sites_) bind(unit.domain);
+  }
+
+  // Built-in container methods run as dedicated instructions. Method id and
+  // argument count are checked here, receiver type is checked on execution.
+  // Receiver is limited to named objects, so it can be fetched again by
+  // method calling if it's not a built-in container.
+  void Bytecode::SelectIntrinsics() {
+    static const unordered_map<string, pair<Operation, size_t>> intrinsics = {
+      { kStrAt, { Operation::IntrinsicAt, 1 } },
+      { kStrSize, { Operation::IntrinsicSize, 0 } },
+      { "push", { Operation::IntrinsicPush, 1 } },
+      { "pop", { Operation::IntrinsicPop, 0 } },
+      { "find", { Operation::IntrinsicFind, 1 } },
+      { "insert", { Operation::IntrinsicInsert, 2 } },
+      { kStrEmpty, { Operation::IntrinsicEmpty, 0 } }
+    };
+
+    for (auto &inst : instructions_) {
+      if (inst.type != NodeType::Function || inst.annotation.use_last_assert) continue;
+
+      auto &site = GetCallSite(inst);
+      auto it = intrinsics.find(site.id);
+
+      if (it == intrinsics.end() || it->second.second != inst.arg_count) continue;
+      if (!compare(site.domain.fetch, FetchKind::Named, FetchKind::Member)) continue;
+
+      inst.type = NodeType::Operation;
+      inst.operation = it->second.first;
+    }
+  }
+
+  // Superinstructions are picked from most frequent operation pairs of
+  // sample scripts:
+  //   comparison + if/elif/while -> CompareBranch
+  //   +=/-= with integer literal  -> IncreaseBy
+  // Branch instruction behind CompareBranch is kept in place. It still
+  // carries nest and branch records, and index of every instruction is
+  // unchanged.
+  void Bytecode::FuseInstructions() {
+    auto is_comparison = [](Operation operation) -> bool {
+      return compare(operation, Operation::Equals, Operation::NotEqual, Operation::Less,
+        Operation::LessOrEqual, Operation::Greater, Operation::GreaterOrEqual);
+    };
+
+    for (size_t idx = 0; idx < instructions_.size(); idx += 1) {
+      auto &inst = instructions_[idx];
+      auto args = GetArguments(inst);
+
+      if (inst.type != NodeType::Operation || inst.arg_count != 2) continue;
+
+      if (is_comparison(inst.operation) && !inst.annotation.void_call &&
+        idx + 1 < instructions_.size()) {
+        auto &next = instructions_[idx + 1];
+
+        if (next.type != NodeType::Operation || next.arg_count != 1) continue;
+        if (!compare(next.operation, Operation::If, Operation::Elif, Operation::While)) continue;
+        if (GetArguments(next)[0].fetch != FetchKind::RetStack) continue;
+
+        inst.origin = inst.operation;
+        inst.operation = Operation::CompareBranch;
+        inst.annotation.void_call = next.annotation.void_call;
+      }
+      else if (compare(inst.operation, Operation::Increase, Operation::Decrease) &&
+        args[1].fetch == FetchKind::Literal && args[1].GetStringType() == LiteralType::Int) {
+        auto &value = args[1].GetData();
+        int64_t int_value = 0;
+        auto result = from_chars(value.data(), value.data() + value.size(), int_value);
+
+        if (result.ec != std::errc() || result.ptr != value.data() + value.size()) continue;
+
+        inst.origin = inst.operation;
+        inst.operation = Operation::IncreaseBy;
+        inst.immediate = inst.origin == Operation::Decrease ? -int_value : int_value;
+      }
+    }
+  }
+
+  bool CaseTable::Add(Object &key, size_t target) {
+    switch (key.GetTypeHandle()) {
+    case kTypeHandleInt: ints.try_emplace(key.Cast<int64_t>(), target); break;
+    case kTypeHandleFloat: floats.try_emplace(key.Cast<double>(), target); break;
+    case kTypeHandleString: strings.try_emplace(key.Cast<string>(), target); break;
+    case kTypeHandleBool: bools.try_emplace(key.Cast<bool>(), target); break;
+    default: return false;
+    }
+
+    return true;
+  }
+
+  size_t CaseTable::Find(Object &key) const {
+    auto find = [this](auto &table, const auto &value) -> size_t {
+      auto it = table.find(value);
+      return it != table.end() ? it->second : fallback;
+    };
+
+    switch (key.GetTypeHandle()) {
+    case kTypeHandleInt: return find(ints, key.Cast<int64_t>());
+    case kTypeHandleFloat: return find(floats, key.Cast<double>());
+    case kTypeHandleString: return find(strings, key.Cast<string>());
+    case kTypeHandleBool: return find(bools, key.Cast<bool>());
+    default: return fallback;
+    }
+  }
+
+  // Case block gets a dispatch table if every when clause is made of
+  // literals. Named keys may be rebound at any time, such block is left to
+  // sequential matching of CommandWhen().
+  void Bytecode::BuildCaseTables() {
+    for (auto &inst : instructions_) {
+      if (inst.type != NodeType::Operation || inst.operation != Operation::Case) continue;
+      if (inst.branch_count == 0) continue;
+
+      CaseTable table(inst.annotation.nest_end);
+      bool good = true;
+
+      for (size_t pos = 0; pos < inst.branch_count && good; pos += 1) {
+        size_t target = branches_[inst.branch_begin + pos];
+        auto &branch = instructions_[target];
+
+        if (branch.operation == Operation::Else) {
+          table.fallback = target;
+          break;
+        }
+
+        auto args = GetArguments(branch);
+        good = branch.operation == Operation::When && !args.empty();
+
+        for (size_t idx = 0; idx < args.size() && good; idx += 1) {
+          good = args[idx].fetch == FetchKind::Literal && args[idx].constant != nullptr &&
+            table.Add(*args[idx].constant, target);
+        }
+      }
+
+      if (!good) continue;
+
+      inst.case_table = case_tables_.size();
+      case_tables_.emplace_back(std::move(table));
+    }
+  }
+
+  // Every instruction pushes one value unless its result is discarded, and
+  // pops the operands taken from return stack. Statements are balanced, so
+  // the running maximum in code order bounds operand stack of this block.
+  void Bytecode::ComputeStackDepth() {
+    auto pops_stack = [](Operand &arg) -> bool {
+      return compare(arg.fetch, FetchKind::RetStack, FetchKind::ChainMember);
+    };
+
+    size_t depth = 0;
+    stack_depth_ = 0;
+
+    for (auto &inst : instructions_) {
+      size_t pops = 0;
+
+      for (auto &arg : GetArguments(inst)) {
+        if (pops_stack(arg)) pops += 1;
+      }
+
+      if (inst.type == NodeType::Function && pops_stack(GetCallSite(inst).domain)) pops += 1;
+
+      depth = depth > pops ? depth - pops : 0;
+      if (!inst.annotation.void_call) depth += 1;
+      if (depth > stack_depth_) stack_depth_ = depth;
+    }
+  }
+
+  Bytecode::Bytecode(AnnotatedAST &source) :
+    instructions_(), operands_(), call_sites_(), branches_(), case_tables_(), 
+    slots_(make_shared<SlotLayout>()), constants_(make_shared<ConstantPool>()), bodies_(), 
+    natives_(), native_(nullptr), jit_block_(), base_(0), hotness_(0), stack_depth_(0) {
+    stack<size_t> branch_record;
+    size_t operand_count = 0;
+
+    for (auto &unit : source) operand_count += unit.second.size();
+
+    instructions_.reserve(source.size());
+    operands_.reserve(operand_count);
+
+    for (size_t idx = 0; idx < source.size(); idx += 1) {
+      auto &node = source[idx].first;
+      auto &args = source[idx].second;
+      Instruction inst;
+
+      inst.type = node.type;
+      inst.operation = node.GetOperation();
+      inst.annotation = node.annotation;
+      inst.line = node.idx;
+      inst.arg_begin = operands_.size();
+      inst.arg_count = args.size();
+
+      for (auto &arg : args) operands_.emplace_back(Operand(arg));
+
+      if (node.type == NodeType::Function) {
+        inst.call_site = call_sites_.size();
+        call_sites_.emplace_back(CallSite(node.GetFunctionId(), Operand(node.GetFunctionDomain())));
+      }
+
+      if (source.FindJumpRecord(idx, branch_record)) {
+        inst.branch_begin = branches_.size();
+        inst.branch_count = branch_record.size();
+
+        while (!branch_record.empty()) {
+          branches_.push_back(branch_record.top());
+          branch_record.pop();
+        }
+      }
+
+      instructions_.emplace_back(inst);
+    }
+
+    AssignSlots();
+    BindConstants();
+    SelectIntrinsics();
+    FuseInstructions();
+    BuildCaseTables();
+    ComputeStackDepth();
+  }
+
+  //Slot layout is shared with source code block
+  Bytecode::Bytecode(Bytecode &source, size_t begin, size_t end) :
+    instructions_(), operands_(), call_sites_(), branches_(), case_tables_(),
+    slots_(source.slots_), constants_(source.constants_), bodies_(), natives_(),
+    native_(nullptr), jit_block_(), base_(source.base_ + begin), hotness_(0), stack_depth_(0) {
+    instructions_.reserve(end - begin);
+
+    for (size_t idx = begin; idx < end; idx += 1) {
+      Instruction inst = source.instructions_[idx];
+      auto args = source.GetArguments(inst);
+
+      inst.arg_begin = operands_.size();
+      operands_.insert(operands_.end(), args.begin(), args.end());
+
+      if (inst.HasCallSite()) {
+        call_sites_.push_back(source.GetCallSite(inst));
+        inst.call_site = call_sites_.size() - 1;
+      }
+
+      if (inst.branch_count != 0) {
+        size_t branch_begin = branches_.size();
+
+        for (size_t pos = 0; pos < inst.branch_count; pos += 1) {
+          branches_.push_back(source.branches_[inst.branch_begin + pos] - begin);
+        }
+
+        inst.branch_begin = branch_begin;
+      }
+
+      //rebase jump targets to this code block
+      if (inst.operation == Operation::End) inst.annotation.nest -= begin;
+      if (inst.annotation.nest_end != 0) inst.annotation.nest_end -= begin;
+
+      inst.case_table = kNoCaseTable;
+      instructions_.emplace_back(inst);
+    }
+
+    BuildCaseTables();
+    ComputeStackDepth();
+    AttachNativeBlocks(source.natives_);
+  }
+
+  void Bytecode::AttachNativeBlocks(shared_ptr<NativeBlockTable> table) {
+    natives_ = table;
+    native_ = nullptr;
+
+    if (natives_ == nullptr) return;
+
+    auto it = natives_->find(base_);
+    if (it != natives_->end()) native_ = it->second;
+  }
+
+  // Body of Fn at idx is sliced once, every function object created by
+  // the same definition shares it. Caches inside the body (call sites,
+  // quickened types) are validated on use, and resolved slots are kept by
+  // each call in its own frame, so sharing is safe.
+  BytecodeHandle Bytecode::GetFunctionBody(size_t idx, size_t nest_end) {
+    auto &body = bodies_[idx];
+
+    //body of malformed definition is empty
+    if (nest_end < idx + 1) nest_end = idx + 1;
+
+    if (body == nullptr) {
+      body = make_shared<Bytecode>(*this, idx + 1, nest_end);
+    }
+
+    return body;
+  }
+
+  bool Bytecode::FetchBranchTargets(size_t idx, JumpRecordStack &dest) {
+    auto &inst = instructions_[idx];
+
+    while (!dest.empty()) dest.pop();
+
+    if (inst.branch_count == 0) return false;
+
+    for (size_t pos = inst.branch_count; pos > 0; pos -= 1) {
+      dest.push(branches_[inst.branch_begin + pos - 1]);
+    }
+
+    return true;
+  }
+}
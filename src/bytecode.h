@@ -0,0 +1,327 @@
+#pragma once
+#include "annotatedAST.h"
+
+namespace sapphire {
+  // Precomputed fetching path of an operand.
+  // FetchObjectView() switches on this value once instead of re-checking
+  // argument type, domain and member access flags on every tick.
+  enum class FetchKind {
+    Literal,      // literal value
+    Named,        // plain identifier in scope
+    Member,       // member of named domain object (a.b)
+    ChainMember,  // member of object on return stack (f().b)
+    LastAssert,   // member of last asserted domain object
+    Unresolved,   // domain object with unsupported type
+    RetStack,     // value on return stack
+    Invalid
+  };
+
+  FetchKind GetFetchKind(Argument &arg);
+  bool MaterializeLiteral(Argument &arg, Object &dest);
+
+  const size_t kNoSlot = std::numeric_limits<size_t>::max();
+
+  // Block end and branch targets of runtime frame
+  using JumpRecordStack = stack<size_t, vector<size_t>>;
+
+  class Operand : public Argument {
+  public:
+    FetchKind fetch;
+    size_t slot;
+    // Literal: entry of constant pool
+    // Identifier: exported constant, used if scope chain has no such object
+    ObjectPointer constant;
+    // Member access: slot of member in last seen struct shape
+    MemberSlotCache member;
+
+  public:
+    Operand() : Argument(), fetch(FetchKind::Invalid), slot(kNoSlot), constant(nullptr), member() {}
+    Operand(const Argument &arg) : 
+      Argument(arg), fetch(FetchKind::Invalid), slot(kNoSlot), constant(nullptr), member() {
+      fetch = GetFetchKind(*this);
+    }
+  };
+
+  // Literal objects of one script, materialized at load time.
+  // Shared by every code block sliced out of the script, entries never move.
+  using ConstantPool = deque<Object>;
+
+  // Resolved object of an identifier.
+  // Valid until binding version of identifier or innermost scope changes.
+  struct ObjectSlot {
+    ObjectPointer ptr;
+    size_t version;
+    size_t scope;
+
+    ObjectSlot() : ptr(nullptr), version(0), scope(0) {}
+
+    bool IsValid(size_t version, size_t scope) const {
+      return this->version == version && this->scope == scope;
+    }
+
+    void Fill(ObjectPointer ptr, size_t version, size_t scope) {
+      this->ptr = ptr;
+      this->version = version;
+      this->scope = scope;
+    }
+  };
+
+  // Slots of one identifier when it's read as plain name and as domain of
+  // member access, kNoSlot if it's not used in that way
+  struct SlotGroup {
+    size_t named;
+    size_t domain;
+
+    SlotGroup() : named(kNoSlot), domain(kNoSlot) {}
+  };
+
+  // Slot indices of one script, shared by every code block sliced out of
+  // it. Lookup results themselves live in RuntimeFrame, one array per call.
+  struct SlotLayout {
+    size_t count;
+    // token id -> slots of identifier, for binding parameters
+    unordered_map<size_t, SlotGroup> tokens;
+    // binding slot -> slots of same identifier, for new local objects
+    unordered_map<size_t, SlotGroup> links;
+
+    SlotLayout() : count(0), tokens(), links() {}
+  };
+
+  // Non-owning view of operand list of an instruction
+  class ArgumentSpan {
+  public:
+    using iterator = Operand *;
+    using reverse_iterator = std::reverse_iterator<Operand *>;
+
+  protected:
+    Operand *data_;
+    size_t size_;
+
+  public:
+    ArgumentSpan() : data_(nullptr), size_(0) {}
+    ArgumentSpan(Operand *data, size_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Operand &operator[](size_t idx) { return data_[idx]; }
+    Operand &back() { return data_[size_ - 1]; }
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+  };
+
+  // Method resolution for one receiver type.
+  // Struct object is found by type id in scope chain, then method is found
+  // in last seen instance or in struct itself. Instance with struct shape
+  // is resolved by index into method table of shape.
+  // Struct bound in global scope is valid in any scope until its binding
+  // version changes (see HasLocalBinding()), struct bound elsewhere is
+  // valid in that scope only.
+  struct MethodCacheEntry {
+    TypeHandle type;
+    size_t type_token;
+    ObjectSlot struct_slot;
+    bool struct_global;
+    size_t struct_serial;
+    size_t struct_version;
+    ObjectPointer struct_method;
+    size_t instance_serial;
+    size_t instance_version;
+    ObjectPointer instance_method;
+    MemberSlotCache instance_member;
+
+    MethodCacheEntry(TypeHandle type, size_t type_token) :
+      type(type), type_token(type_token), struct_slot(), struct_global(false),
+      struct_serial(0), struct_version(0), struct_method(nullptr),
+      instance_serial(0), instance_version(0), instance_method(nullptr),
+      instance_member() {}
+  };
+
+  const size_t kMethodCacheSize = 4;
+
+  // Inline caches of calling instruction.
+  // Plain function call is monomorphic, method call is polymorphic up to
+  // kMethodCacheSize receiver types.
+  struct CallSite {
+    string id;
+    Operand domain;
+    size_t token_id;
+    ObjectSlot callee;
+    vector<MethodCacheEntry> methods;
+    size_t next_victim;
+
+    CallSite(string id, Operand domain) :
+      id(id), domain(domain), token_id(TryAppendTokenId(id)), callee(), 
+      methods(), next_victim(0) {}
+
+    MethodCacheEntry &GetMethodCache(TypeHandle type);
+  };
+
+  const size_t kNoCaseTable = std::numeric_limits<size_t>::max();
+
+  // Dispatch table of case block whose when clauses are all literals.
+  // Key is mapped to index of its when node, first clause wins as in
+  // sequential matching. Missed key goes to else node, or to end of the
+  // block if there's no else.
+  struct CaseTable {
+    unordered_map<int64_t, size_t> ints;
+    unordered_map<double, size_t> floats;
+    unordered_map<string, size_t> strings;
+    unordered_map<bool, size_t> bools;
+    size_t fallback;
+
+    CaseTable(size_t fallback) :
+      ints(), floats(), strings(), bools(), fallback(fallback) {}
+
+    bool Add(Object &key, size_t target);
+    size_t Find(Object &key) const;
+  };
+
+  inline bool IsIntrinsic(Operation operation) {
+    return operation >= Operation::IntrinsicAt && operation <= Operation::IntrinsicEmpty;
+  }
+
+  // Binary operator stops specializing after this many type changes
+  const size_t kQuickenLimit = 4;
+
+  struct Instruction {
+    NodeType type;
+    Operation operation;
+    Annotation annotation;
+    size_t line;
+    size_t arg_begin, arg_count;
+    size_t branch_begin, branch_count;
+    size_t call_site;
+    size_t case_table;
+    TypeHandle quickened;
+    size_t dequickened;
+    Operation origin;
+    int64_t immediate;
+
+    Instruction() :
+      type(NodeType::Invalid), operation(Operation::Null), annotation(), line(0),
+      arg_begin(0), arg_count(0), branch_begin(0), branch_count(0), call_site(0),
+      case_table(kNoCaseTable), quickened(kTypeHandleInvalid), dequickened(0), origin(Operation::Null), immediate(0) {}
+
+    bool IsPlaceholder() const { return type == NodeType::Invalid; }
+
+    // Intrinsic keeps call site of its method for receiver and fallback
+    bool HasCallSite() const { return type == NodeType::Function || IsIntrinsic(operation); }
+
+    // Type feedback of binary operator.
+    // Quickened instruction runs the kernel of operand type directly while
+    // both operands keep this type.
+    bool IsQuickened() const { return quickened != kTypeHandleInvalid; }
+
+    void Quicken(TypeHandle type) {
+      if (dequickened < kQuickenLimit) quickened = type;
+    }
+
+    void Dequicken() {
+      quickened = kTypeHandleInvalid;
+      dequickened += 1;
+    }
+  };
+
+  class Bytecode;
+  using BytecodeHandle = shared_ptr<Bytecode>;
+
+  class NativeRunner;
+  // Translated code of one block, generated by --emit-cpp
+  using NativeBlock = void (*)(NativeRunner &);
+  // Translated blocks of one script, keyed by index of first node of the
+  // block in script (0 for top level, Fn index + 1 for function body)
+  using NativeBlockTable = unordered_map<size_t, NativeBlock>;
+
+  class JitBlock;
+
+  // Flat executable form of AnnotatedAST.
+  // All operands are stored in one contiguous table and every jump target
+  // (nest, nest_end, branch records) is an index local to this code block,
+  // so function bodies can be sliced out without offset bookkeeping.
+  class Bytecode {
+  protected:
+    vector<Instruction> instructions_;
+    vector<Operand> operands_;
+    vector<CallSite> call_sites_;
+    vector<size_t> branches_;
+    vector<CaseTable> case_tables_;
+    shared_ptr<SlotLayout> slots_;
+    shared_ptr<ConstantPool> constants_;
+    // Function bodies sliced out of this block, keyed by index of Fn
+    unordered_map<size_t, BytecodeHandle> bodies_;
+    shared_ptr<NativeBlockTable> natives_;
+    NativeBlock native_;
+    shared_ptr<JitBlock> jit_block_;
+    // Index of first instruction in script
+    size_t base_;
+    // Interpreted commands, for JIT
+    size_t hotness_;
+    size_t stack_depth_;
+
+    void AssignSlots();
+    void BindConstants();
+    void SelectIntrinsics();
+    void FuseInstructions();
+    void BuildCaseTables();
+    void ComputeStackDepth();
+
+  public:
+    Bytecode() : 
+      instructions_(), operands_(), call_sites_(), branches_(), case_tables_(), slots_(), 
+      constants_(), bodies_(), natives_(), native_(nullptr), jit_block_(), base_(0), hotness_(0),
+      stack_depth_(0) {}
+    explicit Bytecode(AnnotatedAST &source);
+    Bytecode(Bytecode &source, size_t begin, size_t end);
+
+    Instruction &operator[](size_t idx) { return instructions_[idx]; }
+    size_t size() const { return instructions_.size(); }
+    bool empty() const { return instructions_.empty(); }
+    auto begin() { return instructions_.begin(); }
+    auto end() { return instructions_.end(); }
+
+    ArgumentSpan GetArguments(Instruction &inst) {
+      return ArgumentSpan(operands_.data() + inst.arg_begin, inst.arg_count);
+    }
+
+    CallSite &GetCallSite(Instruction &inst) {
+      return call_sites_[inst.call_site];
+    }
+
+    CaseTable &GetCaseTable(Instruction &inst) {
+      return case_tables_[inst.case_table];
+    }
+
+    size_t CountSlots() const { return slots_->count; }
+
+    SlotGroup FindSlots(size_t token_id) const {
+      auto it = slots_->tokens.find(token_id);
+      return it != slots_->tokens.end() ? it->second : SlotGroup();
+    }
+
+    SlotGroup FindLinkedSlots(size_t binding_slot) const {
+      auto it = slots_->links.find(binding_slot);
+      return it != slots_->links.end() ? it->second : SlotGroup();
+    }
+    size_t GetStackDepth() const { return stack_depth_; }
+    NativeBlock GetNativeBlock() const { return native_; }
+
+    void AttachNativeBlocks(shared_ptr<NativeBlockTable> table);
+
+    // true once when block gets hot
+    bool Warm(size_t threshold) {
+      return native_ == nullptr && ++hotness_ == threshold;
+    }
+
+    void AttachJitBlock(shared_ptr<JitBlock> block, NativeBlock entry) {
+      jit_block_ = block;
+      native_ = entry;
+    }
+
+    bool FetchBranchTargets(size_t idx, JumpRecordStack &dest);
+    BytecodeHandle GetFunctionBody(size_t idx, size_t nest_end);
+  };
+
+  using BytecodePointer = Bytecode *;
+}
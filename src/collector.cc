@@ -0,0 +1,269 @@
+#include "collector.h"
+
+namespace sapphire {
+  struct TrackedContainer {
+    weak_ptr<void> ptr;
+    CollectableKind kind;
+  };
+
+  // Registry of tracked containers.
+  // During a pass, survivors of visited entries are compacted to the front
+  // (before 'kept'), containers created in the pass are appended after
+  // 'pass_end' and wait for next pass.
+  struct CollectorState {
+    vector<TrackedContainer> entries;
+    size_t cursor;
+    size_t kept;
+    size_t pass_end;
+    size_t trigger;
+    bool in_pass;
+    CollectorStats stats;
+
+    CollectorState() : entries(), cursor(0), kept(0), pass_end(0), trigger(0),
+      in_pass(false), stats() {}
+  };
+
+  static CollectorState &GetCollectorState() {
+    static CollectorState state;
+    return state;
+  }
+
+  void TrackCollectable(const shared_ptr<void> &ptr, CollectableKind kind) {
+    auto threshold = runtime::GetGcThreshold();
+    if (threshold == 0) return;
+
+    auto &state = GetCollectorState();
+    state.entries.push_back(TrackedContainer{ ptr, kind });
+
+    if (!state.in_pass && state.entries.size() >= std::max(state.trigger, threshold)) {
+      state.in_pass = true;
+      state.cursor = 0;
+      state.kept = 0;
+      state.pass_end = state.entries.size();
+      GetCollectionDueFlag() = true;
+    }
+  }
+
+  // Container kind of the content owned by object
+  static CollectableKind GetCollectableKind(Object &obj) {
+    //ref object doesn't own its target
+    if (obj.GetMode() != ObjectMode::Normal || obj.IsUnboxed() || obj.get() == nullptr) {
+      return CollectableKind::None;
+    }
+
+    switch (obj.GetTypeHandle()) {
+    case kTypeHandleArray: return CollectableKind::Array;
+    case kTypeHandleTable: return CollectableKind::Table;
+    case kTypeHandleFunction: return CollectableKind::Function;
+    default: break;
+    }
+
+    return obj.IsSubContainer() ? CollectableKind::Struct : CollectableKind::None;
+  }
+
+  template <typename Visitor>
+  static void VisitMembers(void *ptr, CollectableKind kind, Visitor visitor) {
+    switch (kind) {
+    case CollectableKind::Struct: {
+      //methods in method table are owned by shape, not by container
+      auto &container = *static_cast<ObjectStruct *>(ptr);
+      for (size_t idx = 0; idx < container.CountSlots(); idx += 1) {
+        visitor(container.GetSlot(idx));
+      }
+      for (auto &unit : container.GetContent()) visitor(unit.second);
+      break;
+    }
+    case CollectableKind::Array:
+      for (auto &unit : *static_cast<ObjectArray *>(ptr)) visitor(unit);
+      break;
+    case CollectableKind::Table:
+      for (auto &unit : *static_cast<ObjectTable *>(ptr)) {
+        visitor(const_cast<Object &>(unit.first));
+        visitor(unit.second);
+      }
+      break;
+    case CollectableKind::Function:
+      for (auto &unit : static_cast<Function *>(ptr)->scope) visitor(unit.second);
+      break;
+    default: break;
+    }
+  }
+
+  static void ReleaseMembers(void *ptr, CollectableKind kind) {
+    switch (kind) {
+    case CollectableKind::Struct: static_cast<ObjectStruct *>(ptr)->Recycle(); break;
+    case CollectableKind::Array: static_cast<ObjectArray *>(ptr)->clear(); break;
+    case CollectableKind::Table: static_cast<ObjectTable *>(ptr)->clear(); break;
+    case CollectableKind::Function: static_cast<Function *>(ptr)->scope.clear(); break;
+    default: break;
+    }
+  }
+
+  struct SliceNode {
+    void *ptr;
+    CollectableKind kind;
+    weak_ptr<void> owner;
+    // owners inside the slice
+    size_t internal;
+    size_t edge_begin, edge_end;
+    bool live;
+    // taken from registry, not only reached from other containers
+    bool seeded;
+
+    SliceNode(void *ptr, CollectableKind kind, weak_ptr<void> owner) :
+      ptr(ptr), kind(kind), owner(owner), internal(0), edge_begin(0), edge_end(0),
+      live(false), seeded(false) {}
+  };
+
+  void CollectCycles(const PinnedObjects &pinned) {
+    auto &state = GetCollectorState();
+
+    if (!state.in_pass) {
+      GetCollectionDueFlag() = false;
+      return;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    size_t budget = runtime::GetGcStepBudget();
+    if (budget == 0) budget = std::numeric_limits<size_t>::max();
+
+    vector<SliceNode> nodes;
+    unordered_map<void *, size_t> index;
+    vector<size_t> edges;
+    vector<TrackedContainer> seeds;
+
+    auto append = [&](void *ptr, CollectableKind kind, weak_ptr<void> owner) -> size_t {
+      index.emplace(ptr, nodes.size());
+      nodes.emplace_back(ptr, kind, owner);
+      return nodes.size() - 1;
+    };
+
+    //count owners inside the slice, containers reached from slice join it
+    //until it's full
+    auto visit = [&](size_t idx) -> void {
+      nodes[idx].edge_begin = edges.size();
+
+      VisitMembers(nodes[idx].ptr, nodes[idx].kind, [&](Object &member) {
+        if (member.IsReferenced() || (!pinned.empty() && pinned.count(&member) != 0)) {
+          nodes[idx].live = true;
+        }
+
+        auto kind = GetCollectableKind(member);
+        if (kind == CollectableKind::None) return;
+
+        size_t target;
+        if (auto it = index.find(member.get()); it != index.end()) target = it->second;
+        else if (nodes.size() < budget) target = append(member.get(), kind, member);
+        else return;
+
+        nodes[target].internal += 1;
+        edges.push_back(target);
+      });
+
+      nodes[idx].edge_end = edges.size();
+    };
+
+    //seeds of this step are taken from registry in order. Members of a
+    //seed are visited before next seed is taken, so a cycle which fits in
+    //the budget is never split by the border of slices.
+    size_t visited = 0;
+
+    for (;;) {
+      while (visited < nodes.size()) {
+        visit(visited);
+        visited += 1;
+      }
+
+      if (state.cursor >= state.pass_end || nodes.size() >= budget) break;
+
+      auto &entry = state.entries[state.cursor];
+      state.cursor += 1;
+      void *ptr = entry.ptr.lock().get();
+      if (ptr == nullptr) continue;
+      auto it = index.find(ptr);
+      size_t target = it != index.end() ? it->second : append(ptr, entry.kind, entry.ptr);
+      //same container is registered more than once
+      if (nodes[target].seeded) continue;
+      nodes[target].seeded = true;
+      seeds.push_back(std::move(entry));
+    }
+
+    //container owned from outside of the slice is alive, and so is
+    //everything reachable from it
+    vector<size_t> worklist;
+    for (size_t idx = 0; idx < nodes.size(); idx += 1) {
+      auto &node = nodes[idx];
+      if (!node.live && static_cast<size_t>(node.owner.use_count()) > node.internal) {
+        node.live = true;
+      }
+      if (node.live) worklist.push_back(idx);
+    }
+
+    while (!worklist.empty()) {
+      auto &node = nodes[worklist.back()];
+      worklist.pop_back();
+      for (size_t idx = node.edge_begin; idx < node.edge_end; idx += 1) {
+        auto &target = nodes[edges[idx]];
+        if (target.live) continue;
+        target.live = true;
+        worklist.push_back(edges[idx]);
+      }
+    }
+
+    //garbage is held until all of it is cleared, so no container is
+    //destroyed while another one is still being cleared
+    vector<shared_ptr<void>> garbage;
+    for (auto &node : nodes) {
+      if (!node.live) garbage.push_back(node.owner.lock());
+    }
+    for (auto &node : nodes) {
+      if (!node.live) ReleaseMembers(node.ptr, node.kind);
+    }
+    size_t freed = garbage.size();
+    garbage.clear();
+
+    for (auto &seed : seeds) {
+      if (seed.ptr.expired()) continue;
+      state.entries[state.kept] = std::move(seed);
+      state.kept += 1;
+    }
+
+    auto &stats = state.stats;
+
+    if (state.cursor == state.pass_end) {
+      //containers created during this pass are kept for next pass
+      auto &entries = state.entries;
+      size_t created = entries.size() - state.pass_end;
+      std::move(entries.begin() + state.pass_end, entries.end(), entries.begin() + state.kept);
+      entries.resize(state.kept + created);
+      state.in_pass = false;
+      state.trigger = static_cast<size_t>(static_cast<double>(entries.size()) * runtime::GetGcGrowth());
+      stats.collections += 1;
+      GetCollectionDueFlag() = false;
+    }
+
+    auto pause = std::chrono::steady_clock::now() - begin;
+    stats.steps += 1;
+    stats.scanned += nodes.size();
+    stats.freed += freed;
+    stats.total_pause += pause;
+    if (pause > stats.max_pause) stats.max_pause = pause;
+  }
+
+  const CollectorStats &GetCollectorStats() {
+    return GetCollectorState().stats;
+  }
+
+  void PrintCollectorStats() {
+    auto &state = GetCollectorState();
+    auto &stats = state.stats;
+    auto to_ms = [](std::chrono::nanoseconds value) -> double {
+      return std::chrono::duration<double, std::milli>(value).count();
+    };
+
+    printf("GC: collections=%zu steps=%zu scanned=%zu freed=%zu tracked=%zu\n",
+      stats.collections, stats.steps, stats.scanned, stats.freed, state.entries.size());
+    printf("GC: total pause=%.3fms max pause=%.3fms\n",
+      to_ms(stats.total_pause), to_ms(stats.max_pause));
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "management.h"
+
+namespace sapphire {
+  // Cycle collector of container heap.
+  // Objects are reference counted, so containers holding each other (struct
+  // instances, arrays, tables and closure scopes of functions) are never
+  // released. Every container is tracked since creation, and collection
+  // runs as trial deletion over a slice of tracked containers: a container
+  // whose owners are all inside the slice, and which is not reachable from
+  // any container owned from outside, is garbage. Containers reached from
+  // a seed join its slice first, so a cycle is found if all of its
+  // containers fit in one step (--gc-step).
+  // A pass over all tracked containers is split into steps of bounded size,
+  // machine runs one step at a time between commands. Next pass begins when
+  // tracked containers grow to (live containers of last pass * growth).
+  struct CollectorStats {
+    size_t collections;   // finished passes
+    size_t steps;
+    size_t scanned;       // containers in slices of all steps
+    size_t freed;
+    std::chrono::nanoseconds total_pause;
+    std::chrono::nanoseconds max_pause;
+
+    CollectorStats() : collections(0), steps(0), scanned(0), freed(0),
+      total_pause(0), max_pause(0) {}
+  };
+
+  // Checked between commands, collection is due until current pass ends
+  inline bool &GetCollectionDueFlag() {
+    static bool due = false;
+    return due;
+  }
+
+  // Objects on operand stacks and other places which are only seen by
+  // raw pointer, containers holding them are kept alive
+  using PinnedObjects = unordered_set<ObjectPointer>;
+
+  void CollectCycles(const PinnedObjects &pinned);
+  const CollectorStats &GetCollectorStats();
+  void PrintCollectorStats();
+}
@@ -39,6 +39,8 @@
 #include <optional>
 #include <mutex>
 #include <atomic>
+#include <limits>
+#include <chrono>
 
 #include "toml11/toml.hpp"
 #include "log.h"
@@ -76,6 +78,7 @@ namespace sapphire {
   using std::deque;
   using std::shared_ptr;
   using std::unique_ptr;
+  using std::weak_ptr;
   using std::static_pointer_cast;
   using std::dynamic_pointer_cast;
   using std::make_shared;
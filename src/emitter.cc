@@ -0,0 +1,247 @@
+#include "emitter.h"
+#include "native.h"
+
+namespace sapphire {
+  const char *kOperationNames[] = {
+    "Assert", "Local", "Load", "For", "In", "NullObj", "Swap", "ExpList", "Fn", "If",
+    "Elif", "End", "Else", "Bind", "Delivering", "ConstraintArrow", "While", "Plus",
+    "Minus", "Times", "Divide", "Equals", "LessOrEqual", "GreaterOrEqual", "NotEqual",
+    "Greater", "Less", "Return", "And", "Or", "Not", "Increase", "Decrease", "InitialArray",
+    "Continue", "Break", "Case", "When", "TypeId", "Using", "Struct", "Module",
+    "DomainAssertCommand", "Include", "Super", "IsVariableParam", "Attribute", "Print",
+    "PrintLine", "Sleep", "ShortCircuit", "Unbind", "CompareBranch", "IncreaseBy",
+    "IntrinsicAt", "IntrinsicSize", "IntrinsicPush", "IntrinsicPop", "IntrinsicFind",
+    "IntrinsicInsert", "IntrinsicEmpty", "Null"
+  };
+
+  static_assert(sizeof(kOperationNames) / sizeof(kOperationNames[0]) ==
+    static_cast<size_t>(Operation::Null) + 1, "Operation name table is out of date");
+
+  const char *kArgumentTypeNames[] = { "Literal", "Pool", "RetStack", "Invalid" };
+
+  const char *kLiteralTypeNames[] = {
+    "Identifier", "String", "Int", "Float", "Bool", "Symbol", "Whitespace", "Invalid"
+  };
+
+  string OperationName(Operation operation) {
+    return string("Operation::") + kOperationNames[static_cast<size_t>(operation)];
+  }
+
+  string ArgumentTypeName(ArgumentType type) {
+    return string("ArgumentType::") + kArgumentTypeNames[static_cast<size_t>(type)];
+  }
+
+  string LiteralTypeName(LiteralType type) {
+    return string("LiteralType::") + kLiteralTypeNames[static_cast<size_t>(type)];
+  }
+
+  CppEmitter::CppEmitter(AnnotatedAST &ast, string path) :
+    ast_(ast), path_(path), script_path_(), code_(ast), tokens_(), blocks_(), output_() {
+    for (auto &unit : GetTokenIdMap()) {
+      if (unit.second >= tokens_.size()) tokens_.resize(unit.second + 1, nullptr);
+      tokens_[unit.second] = &unit.first;
+    }
+  }
+
+  string CppEmitter::Quote(const string &str) {
+    string result = "\"";
+    char buffer[8];
+
+    for (auto unit : str) {
+      switch (unit) {
+      case '\\': result.append("\\\\"); break;
+      case '"': result.append("\\\""); break;
+      case '\n': result.append("\\n"); break;
+      case '\t': result.append("\\t"); break;
+      default:
+        if (static_cast<unsigned char>(unit) < 0x20 || unit == 0x7f) {
+          snprintf(buffer, sizeof(buffer), "\\%03o", static_cast<unsigned char>(unit));
+          result.append(buffer);
+        }
+        else {
+          result.push_back(unit);
+        }
+        break;
+      }
+    }
+
+    result.push_back('"');
+    return result;
+  }
+
+  string CppEmitter::TokenOf(size_t token_id) {
+    if (token_id == 0 || token_id >= tokens_.size() || tokens_[token_id] == nullptr) {
+      return "nullptr";
+    }
+
+    return Quote(*tokens_[token_id]);
+  }
+
+  string CppEmitter::WriteArgument(Argument &arg) {
+    auto &properties = arg.properties;
+    unsigned flags = 0;
+    string result = "NativeArgument(" + Quote(arg.GetData()) + ", " +
+      ArgumentTypeName(arg.GetType()) + ", " + LiteralTypeName(arg.GetStringType());
+
+    if (properties.fn.variable_param) flags |= kNativeVariableParam;
+    if (properties.fn.constraint) flags |= kNativeConstraint;
+    if (properties.member_access.use_last_assert) flags |= kNativeLastAssert;
+    if (properties.member_access.is_chain_tail) flags |= kNativeChainTail;
+
+    if (flags != 0 || arg.HasDomain() || properties.token_id != 0) {
+      result.append(", " + to_string(flags) + ", " + Quote(properties.domain.id) + ", " +
+        ArgumentTypeName(properties.domain.type) + ", " + TokenOf(properties.token_id));
+    }
+
+    result.push_back(')');
+    return result;
+  }
+
+  string CppEmitter::WriteAnnotation(Annotation &annotation) {
+    unsigned flags = 0;
+
+    if (annotation.void_call) flags |= kNativeVoidCall;
+    if (annotation.local_object) flags |= kNativeLocalObject;
+    if (annotation.ext_object) flags |= kNativeExtObject;
+    if (annotation.use_last_assert) flags |= kNativeUseLastAssert;
+    if (annotation.tail_call) flags |= kNativeTailCall;
+
+    return "NativeAnnotation(" + to_string(flags) + ", " + to_string(annotation.nest) + ", " +
+      to_string(annotation.nest_end) + ", " + to_string(annotation.escape_depth) + ", " +
+      OperationName(annotation.nest_root) + ")";
+  }
+
+  void CppEmitter::WriteScriptBuilder() {
+    map<size_t, list<size_t>> jump_records(
+      ast_.GetJumpRecords().begin(), ast_.GetJumpRecords().end());
+
+    output_.append("  void BuildScript(AnnotatedAST &ast) {\n");
+
+    for (auto &unit : ast_) {
+      auto &node = unit.first;
+      string line = to_string(node.idx);
+
+      output_.append("    ast.emplace_back(");
+
+      if (node.type == NodeType::Function) {
+        auto domain = node.GetFunctionDomain();
+        output_.append("NativeCall(" + Quote(node.GetFunctionId()) + ", " + WriteArgument(domain) +
+          ", " + line + ", " + WriteAnnotation(node.annotation) + ")");
+      }
+      else {
+        output_.append("NativeNode(" + OperationName(node.GetOperation()) + ", " + line + ", " +
+          WriteAnnotation(node.annotation) + ")");
+      }
+
+      output_.append(", ArgumentList{");
+
+      for (size_t idx = 0; idx < unit.second.size(); idx += 1) {
+        output_.append(idx == 0 ? "\n      " : ",\n      ");
+        output_.append(WriteArgument(unit.second[idx]));
+      }
+
+      output_.append(" });\n");
+    }
+
+    for (auto &unit : jump_records) {
+      string record;
+
+      for (auto target : unit.second) {
+        record.append(record.empty() ? " " : ", ");
+        record.append(to_string(target));
+      }
+
+      output_.append("    ast.AddJumpRecord(" + to_string(unit.first) + ", {" + record + " });\n");
+    }
+
+    output_.append("  }\n\n");
+  }
+
+  // Block is [begin, end) of script, case labels are indices local to the
+  // block as function body is sliced out. Every command falls through to
+  // the next one while it keeps running in place.
+  void CppEmitter::WriteBlock(size_t begin, size_t end) {
+    vector<pair<size_t, size_t>> bodies;
+    string cases;
+
+    auto is_native = [this](size_t idx) -> bool {
+      return code_[idx].type == NodeType::Operation && IsNativeCommand(code_[idx].operation);
+    };
+
+    for (size_t idx = begin; idx < end; idx += 1) {
+      auto &inst = code_[idx];
+
+      if (is_native(idx)) {
+        string local = to_string(idx - begin);
+        bool fallthrough = idx + 1 < end && is_native(idx + 1) && inst.operation != Operation::Fn;
+
+        cases.append("      case " + local + ": if (!runner.Execute<" + 
+          OperationName(inst.operation) + ">(" + local + ")) break; ");
+        cases.append(fallthrough ? "[[fallthrough]];\n" : "return;\n");
+      }
+
+      if (inst.operation == Operation::Fn && inst.type == NodeType::Operation &&
+        inst.annotation.nest_end > idx) {
+        bodies.emplace_back(idx + 1, inst.annotation.nest_end);
+        idx = inst.annotation.nest_end - 1;
+      }
+    }
+
+    if (!cases.empty()) {
+      string name = "Block" + to_string(begin);
+
+      output_.append("  void " + name + "(NativeRunner &runner) {\n");
+      output_.append("    for (;;) {\n      switch (runner.Index()) {\n");
+      output_.append(cases);
+      output_.append("      default: return;\n      }\n\n");
+      output_.append("      if (!runner.Resumable()) return;\n    }\n  }\n\n");
+      blocks_.push_back(begin);
+    }
+
+    for (auto &unit : bodies) WriteBlock(unit.first, unit.second);
+  }
+
+  void CppEmitter::WriteEntry() {
+    output_.append("  const NativeBlockEntry kBlocks[] = {\n");
+
+    for (auto unit : blocks_) {
+      output_.append("    { " + to_string(unit) + ", Block" + to_string(unit) + " },\n");
+    }
+
+    output_.append("    { 0, nullptr }\n  };\n\n");
+    output_.append("  const NativeScript kScript = { " + Quote(script_path_) + ", BuildScript, kBlocks, " +
+      to_string(blocks_.size()) + " };\n");
+    output_.append("}\n\n");
+    output_.append(
+      "extern \"C\" int sapphire_native_main(int argc, char **argv) {\n"
+      "  return NativeScriptMain(kScript, argc, argv);\n"
+      "}\n\n"
+      "#ifdef SAPPHIRE_NATIVE_MAIN\n"
+      "int main(int argc, char **argv) {\n"
+      "  return sapphire_native_main(argc, argv);\n"
+      "}\n"
+      "#endif\n");
+  }
+
+  bool CppEmitter::Start(string dest) {
+    //translated source doesn't depend on location of build tree
+    auto dest_dir = fs::absolute(fs::path(dest)).parent_path();
+    script_path_ = fs::path(path_).lexically_relative(dest_dir).generic_string();
+    if (script_path_.empty()) script_path_ = path_;
+
+    output_ = "// Translated from " + script_path_ + " by --emit-cpp, do not edit.\n";
+    output_.append("#include \"native.h\"\n\nusing namespace sapphire;\n\nnamespace {\n");
+    blocks_.clear();
+
+    WriteScriptBuilder();
+    WriteBlock(0, code_.size());
+    WriteEntry();
+
+    FILE *fp = fopen(dest.data(), "w");
+    if (fp == nullptr) return false;
+
+    bool good = fputs(output_.data(), fp) >= 0;
+    fclose(fp);
+    return good;
+  }
+}
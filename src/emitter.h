@@ -0,0 +1,35 @@
+#pragma once
+#include "machine.h"
+
+namespace sapphire {
+  // Translating script into C++ source (--emit-cpp), see native.h.
+  // Nodes are written out to be rebuilt at startup, and each block (top
+  // level and function bodies) gets a function running its commands by
+  // direct calls in node order. Calling, returning and other dynamic parts
+  // are left to interpreter.
+  class CppEmitter {
+  protected:
+    AnnotatedAST &ast_;
+    string path_;
+    // path_ relative to directory of translated source
+    string script_path_;
+    Bytecode code_;
+    vector<const string *> tokens_;
+    vector<size_t> blocks_;
+    string output_;
+
+    string Quote(const string &str);
+    string TokenOf(size_t token_id);
+    string WriteArgument(Argument &arg);
+    string WriteAnnotation(Annotation &annotation);
+    void WriteScriptBuilder();
+    void WriteBlock(size_t begin, size_t end);
+    void WriteEntry();
+
+  public:
+    CppEmitter() = delete;
+    CppEmitter(AnnotatedAST &ast, string path);
+
+    bool Start(string dest);
+  };
+}
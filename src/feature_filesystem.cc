@@ -5,28 +5,28 @@ namespace sapphire {
   int ExistFSObject(State &state, ObjectMap &p) {
     auto &path = p.Cast<string>("path");
     auto exists = fs::exists(fs::path(path));
-    state.PushValue(Object(exists, kTypeIdBool));
+    state.PushValue(Object(exists, kTypeHandleBool));
     return 0;
   }
 
   int CreateNewDirectory(State &state, ObjectMap &p) {
     auto &path = p.Cast<string>("path");
     auto result = fs::create_directories(path);
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
   int RemoveFSObject(State &state, ObjectMap &p) {
     auto &path = p.Cast<string>("path");
     auto result = fs::remove(fs::path(path));
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
   int RemoveFSObject_Recursive(State &state, ObjectMap &p) {
     auto &path = p.Cast<string>("path");
     auto result = fs::remove_all(fs::path(path));
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
   
@@ -50,7 +50,7 @@ namespace sapphire {
     auto from = p.Cast<string>("from");
     auto to = p.Cast<string>("to");
     auto result = fs::copy_file(fs::path(from), fs::path(to));
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
@@ -61,29 +61,29 @@ namespace sapphire {
     dest_dir = dir_obj.Cast<string>();
 
     bool result = runtime::SetWorkingDirectory(dest_dir);
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
   int StartHere(State &state, ObjectMap &p) {
     using namespace runtime;
     auto result = SetWorkingDirectory(GetScriptAbsolutePath());
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
   int GetWorkingDir(State &state, ObjectMap &p) {
-    state.PushValue(Object(runtime::GetWorkingDirectory(), kTypeIdString));
+    state.PushValue(Object(runtime::GetWorkingDirectory(), kTypeHandleString));
     return 0;
   }
 
   int GetScriptAbsolutePath(State &state, ObjectMap &p) {
-    state.PushValue(Object(runtime::GetScriptAbsolutePath(), kTypeIdString));
+    state.PushValue(Object(runtime::GetScriptAbsolutePath(), kTypeHandleString));
     return 0;
   }
 
   int GetCoreAbsolutePath(State &state, ObjectMap &p) {
-    state.PushValue(Object(runtime::GetBinaryPath(), kTypeIdString));
+    state.PushValue(Object(runtime::GetBinaryPath(), kTypeHandleString));
     return 0;
   }
 
@@ -91,16 +91,16 @@ namespace sapphire {
     string path_str = p.Cast<string>("path");
     auto managed_array = make_shared<ObjectArray>();
     for (auto &unit : fs::directory_iterator(path_str)) {
-      managed_array->emplace_back(Object(unit.path().string(), kTypeIdString));
+      managed_array->emplace_back(Object(unit.path().string(), kTypeHandleString));
     }
 
-    state.PushValue(Object(managed_array, kTypeIdArray));
+    state.PushValue(Object(managed_array, kTypeHandleArray));
     return 0;
   }
 
   int GetFilenameExtension(State &state, ObjectMap &p) {
     fs::path value(p.Cast<string>("path"));
-    state.PushValue(Object(value.extension().string(), kTypeIdString));
+    state.PushValue(Object(value.extension().string(), kTypeHandleString));
     return 0;
   }
 
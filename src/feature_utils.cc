@@ -3,20 +3,20 @@
 namespace sapphire {
   int NullObj(State &state, ObjectMap &p) {
     auto &obj = p["obj"];
-    state.PushValue(Object(obj.GetTypeId() == kTypeIdNull, kTypeIdBool));
+    state.PushValue(Object(obj.GetTypeHandle() == kTypeHandleNull, kTypeHandleBool));
     return 0;
   }
 
   int Input(State &state, ObjectMap &p) {
     string buf = GetLine();
-    state.PushValue(Object(buf, kTypeIdString));
+    state.PushValue(Object(buf, kTypeHandleString));
     return 0;
   }
 
   int SystemConsole(State &state, ObjectMap &p) {
     auto cmd = p.Cast<string>("cmd");
     int64_t result = system(cmd.data());
-    state.PushValue(Object(result, kTypeIdInt));
+    state.PushValue(Object(result, kTypeHandleInt));
     return 0;
   }
 
@@ -24,7 +24,7 @@ namespace sapphire {
     time_t now = time(nullptr);
     string nowtime(ctime(&now));
     nowtime.pop_back();
-    state.PushValue(Object(nowtime, kTypeIdString));
+    state.PushValue(Object(nowtime, kTypeHandleString));
     return 0;
   }
 
@@ -33,11 +33,11 @@ namespace sapphire {
     auto &target = p["target"];
 
     if (!target.IsSubContainer()) {
-      state.PushValue(Object(false, kTypeIdBool));
+      state.PushValue(Object(false, kTypeHandleBool));
       return 0;
     }
 
-    if (!compare(kTypeIdStruct, base.GetTypeId(), target.GetTypeId())) {
+    if (!compare(kTypeHandleStruct, base.GetTypeHandle(), target.GetTypeHandle())) {
       state.SetMsg("Invalid struct");
       return 2;
     }
@@ -45,7 +45,7 @@ namespace sapphire {
     auto *super_struct_ref = target.Cast<ObjectStruct>().Find(kStrSuperStruct);
 
     if (super_struct_ref == nullptr) {
-      state.PushValue(Object(false, kTypeIdBool));
+      state.PushValue(Object(false, kTypeHandleBool));
       return 0;
     }
 
@@ -55,7 +55,7 @@ namespace sapphire {
     }
 
     auto target_base = super_struct_ref->Get();
-    state.PushValue(Object(target_base == base.Get(), kTypeIdBool));
+    state.PushValue(Object(target_base == base.Get(), kTypeHandleBool));
     return 0;
   }
 
@@ -69,7 +69,7 @@ namespace sapphire {
         auto ptr = base.Find(unit);
 
         if (ptr == nullptr) result = false;
-        else if (ptr->GetTypeId() != kTypeIdFunction) result = false;
+        else if (ptr->GetTypeHandle() != kTypeHandleFunction) result = false;
 
         if (!result) return;
       }
@@ -98,7 +98,7 @@ namespace sapphire {
     auto &obj = p["obj"];
 
     auto result = CheckObjectBehavior(state, obj, behaviors);
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
@@ -109,14 +109,14 @@ namespace sapphire {
     if (obj.IsSubContainer()) {
       auto &base = obj.Cast<ObjectStruct>();
       auto ptr = base.Find(id);
-      result = (ptr != nullptr && ptr->GetTypeId() == kTypeIdFunction);
+      result = (ptr != nullptr && ptr->GetTypeHandle() == kTypeHandleFunction);
     }
     else {
       auto *struct_obj_ptr = obj_stack.Find(obj.GetTypeId(), TryAppendTokenId(obj.GetTypeId()));
       if (struct_obj_ptr != nullptr && struct_obj_ptr->IsSubContainer()) {
         auto &base = struct_obj_ptr->Cast<ObjectStruct>();
         auto ptr = base.Find(id);
-        result = (ptr != nullptr && ptr->GetTypeId() == kTypeIdFunction);
+        result = (ptr != nullptr && ptr->GetTypeHandle() == kTypeHandleFunction);
       }
     }
 
@@ -130,16 +130,14 @@ namespace sapphire {
     bool first_stage = CheckObjectMethod(state, obj, str);
     bool second_stage = obj.IsSubContainer() ?
       [&]() -> bool {
-      auto &container = obj.Cast<ObjectStruct>().GetContent();
-      for (auto &unit : container) {
-        if (unit.first == str) {
-          return true;
-        }
-      }
-      return false;
+      bool found = false;
+      obj.Cast<ObjectStruct>().ForEach([&](const string &id, Object &) {
+        if (id == str) found = true;
+      });
+      return found;
     }() : false;
 
-    state.PushValue(Object(first_stage || second_stage, kTypeIdBool));
+    state.PushValue(Object(first_stage || second_stage, kTypeHandleBool));
     return 0;
   }
 
@@ -147,17 +145,18 @@ namespace sapphire {
     auto &obj_stack = state.AccessScope();
 
     if (obj.IsSubContainer()) {
-      auto &base = obj.Cast<ObjectStruct>().GetContent();
-
-      for (const auto &unit : base) dest.emplace_back(unit.first);
+      obj.Cast<ObjectStruct>().ForEach([&](const string &id, Object &) {
+        dest.emplace_back(id);
+      });
       //apppend 'members' method
-      if (obj.GetTypeId() == kTypeIdStruct) dest.emplace_back("members");
+      if (obj.GetTypeHandle() == kTypeHandleStruct) dest.emplace_back("members");
     }
     else {
       auto *struct_obj_ptr = obj_stack.Find(obj.GetTypeId(), TryAppendTokenId(obj.GetTypeId()));
       if (struct_obj_ptr != nullptr && struct_obj_ptr->IsSubContainer()) {
-        auto &base = struct_obj_ptr->Cast<ObjectStruct>().GetContent();
-        for (const auto &unit : base) dest.emplace_back(unit.first);
+        struct_obj_ptr->Cast<ObjectStruct>().ForEach([&](const string &id, Object &) {
+          dest.emplace_back(id);
+        });
       }
     }
   }
@@ -170,19 +169,18 @@ namespace sapphire {
     GetObjectMethods(state, obj, temp);
 
     for (auto &unit : temp) {
-      managed_array->emplace_back(Object(unit, kTypeIdString));
+      managed_array->emplace_back(Object(unit, kTypeHandleString));
     }
 
     if (obj.IsSubContainer()) {
-      auto &container = obj.Cast<ObjectStruct>().GetContent();
-      for (auto &unit : container) {
-        if (unit.second.GetTypeId() == kTypeIdFunction) {
-          managed_array->emplace_back(unit.first);
+      obj.Cast<ObjectStruct>().ForEach([&](const string &id, Object &member) {
+        if (member.GetTypeHandle() == kTypeHandleFunction) {
+          managed_array->emplace_back(id);
         }
-      }
+      });
     }
 
-    state.PushValue(Object(managed_array, kTypeIdArray));
+    state.PushValue(Object(managed_array, kTypeHandleArray));
     return 0;
   }
 
@@ -192,13 +190,13 @@ namespace sapphire {
 
     switch(type) {
     case LiteralType::Int:
-      state.PushValue(Object(stol(str), kTypeIdInt));
+      state.PushValue(Object(stol(str), kTypeHandleInt));
       break;
     case LiteralType::Float:
-      state.PushValue(Object(stod(str), kTypeIdFloat));
+      state.PushValue(Object(stod(str), kTypeHandleFloat));
       break;
     case LiteralType::Bool:
-      state.PushValue(Object(str == kStrTrue, kTypeIdBool));
+      state.PushValue(Object(str == kStrTrue, kTypeHandleBool));
       break;
     default:
       break;
@@ -208,12 +206,12 @@ namespace sapphire {
   }
 
   int Version(State &state, ObjectMap &p) {
-    state.PushValue(Object(string(BUILD), kTypeIdString));
+    state.PushValue(Object(string(BUILD), kTypeHandleString));
     return 0;
   }
 
   int Codename(State &state, ObjectMap &p) {
-    state.PushValue(Object(string(CODENAME), kTypeIdString));
+    state.PushValue(Object(string(CODENAME), kTypeHandleString));
     return 0;
   }
 
@@ -35,6 +35,8 @@ namespace sapphire {
       operation == Operation::For;
   }
 
+  const size_t kNoLogicJump = std::numeric_limits<size_t>::max();
+
   inline bool IsSingleKeyword(Operation operation) {
     return operation == Operation::End ||
       operation == Operation::Else ||
@@ -333,6 +335,9 @@ namespace sapphire {
 
     action_base_.emplace_back(Sentense(frame_->nodes.back(), arguments));
     frame_->nodes.pop_back();
+    if (compare(action_base_.back().first.GetOperation(), Operation::And, Operation::Or)) {
+      ResolveLogicJump();
+    }
     frame_->args.emplace_back(Argument("", ArgumentType::RetStack, LiteralType::Invalid));
     if (frame_->nodes.empty() && !IgnoreVoidCall(action_base_.back().first.GetOperation()) &&
       (frame_->next.first == "," || frame_->next.second == LiteralType::Invalid)) {
@@ -440,9 +445,42 @@ namespace sapphire {
       }
     }
 
+    //left operand is complete, it's tested before evaluating right operand
+    if (compare(token, Operation::And, Operation::Or)) {
+      if (!frame_->args.empty() && !frame_->args.back().IsPlaceholder()) {
+        frame_->logic_jumps.push(action_base_.size());
+        action_base_.emplace_back(Sentense(ASTNode(Operation::ShortCircuit), { frame_->args.back() }));
+        frame_->args.back() = Argument("", ArgumentType::RetStack, LiteralType::Invalid);
+      }
+      else {
+        frame_->logic_jumps.push(kNoLogicJump);
+      }
+    }
+
     frame_->nodes.emplace_back(node);
   }
 
+  // Operator node of &&/|| is at the back of output. ShortCircuit node jumps
+  // to the node behind it. Right operand without any node can't be skipped,
+  // left operand is given back to operator node in that case.
+  void FirstStageParsing::ResolveLogicJump() {
+    if (frame_->logic_jumps.empty()) return;
+
+    size_t jump = frame_->logic_jumps.top();
+    auto &sentense = action_base_.back();
+    frame_->logic_jumps.pop();
+
+    if (jump == kNoLogicJump || sentense.second.size() != 2) return;
+
+    if (jump + 2 == action_base_.size()) {
+      sentense.second[0] = action_base_[jump].second[0];
+      action_base_.erase(action_base_.begin() + jump);
+    }
+    else {
+      action_base_[jump].first.annotation.nest_end = action_base_.size();
+    }
+  }
+
   bool FirstStageParsing::FunctionHeaderStmt() {
     //TODO:Preprecessing-time argument type checking
 
@@ -947,6 +985,13 @@ namespace sapphire {
       anchor.swap(parser.GetOutput());
       parser.Clear();
 
+      //jump targets inside the line are rebased to the script
+      for (auto &unit : anchor) {
+        if (unit.first.GetOperation() == Operation::ShortCircuit) {
+          unit.first.annotation.nest_end += dest_->size();
+        }
+      }
+
       if (inside_struct_) {
         if (ast_root == Operation::Fn) struct_member_fn_nest += 1;
 
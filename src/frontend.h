@@ -95,6 +95,8 @@ namespace sapphire {
     Token next_2;
     Token last;
     Argument domain;
+    // Index of ShortCircuit node for each pending &&/||
+    stack<size_t> logic_jumps;
     deque<Token> &tokens;
 
     ParserFrame(deque<Token> &tokens) :
@@ -110,6 +112,7 @@ namespace sapphire {
       next_2(INVALID_TOKEN),
       last(INVALID_TOKEN),
       domain(),
+      logic_jumps(),
       tokens(tokens) {}
 
     void Eat();
@@ -134,6 +137,7 @@ namespace sapphire {
     bool GetElementStmt();
     bool ArrayGeneratorStmt();
     void BinaryExpr();
+    void ResolveLogicJump();
     bool FunctionHeaderStmt();
     bool StructHeaderStmt(Terminator terminator);
     bool ForEachStmt();
@@ -1,5 +1,5 @@
 #pragma once
-#include "annotatedAST.h"
+#include "bytecode.h"
 
 namespace sapphire {
   using GenericFunctionPointer = void(*)();
@@ -30,12 +30,12 @@ namespace sapphire {
   };
 
   using ComponentFunction = FunctionBase<Activity>;
-  using UserDefinedFunction = FunctionBase<AnnotatedAST>;
+  using UserDefinedFunction = FunctionBase<BytecodeHandle>;
   using InvalidFunction = FunctionBase <FunctionPlacebo>;
 
   using FunctionSlot = variant<
     FunctionBase<Activity>,
-    FunctionBase<AnnotatedAST>,
+    FunctionBase<BytecodeHandle>,
     //FuntionBase<ExtensionActivity>,
     FunctionBase<FunctionPlacebo>
   >;
@@ -65,6 +65,8 @@ namespace sapphire {
     bool variable_param_;
     FunctionType type_;
     vector<string> params_;
+    vector<size_t> param_tokens_;
+    vector<SlotGroup> param_slots_;
     string id_; //preserved for compatibility,  remove it in the future
 
   public:
@@ -72,32 +74,43 @@ namespace sapphire {
       slot_(InvalidFunction()), scope(),
       variable_param_(false),
       type_(FunctionType::Invalid),
-      params_(), id_() {}
+      params_(), param_tokens_(), param_slots_(), id_() {}
 
     Function(Activity activity, string params, string id, bool variable = false) :
       slot_(ComponentFunction(activity, 0)), scope(),
       variable_param_(variable),
       type_(FunctionType::Component),
-      params_(BuildStringVector(params)), id_(id) {}
+      params_(BuildStringVector(params)), param_tokens_(), param_slots_(), id_(id) {}
 
-    Function(size_t offset, AnnotatedAST ir, string id, vector<string> params, bool variable = false) :
-      slot_(UserDefinedFunction(ir, offset)), scope(),
+    Function(BytecodeHandle code, string id, vector<string> params, bool variable = false) :
+      slot_(UserDefinedFunction(code, 0)), scope(),
       variable_param_(variable),
       type_(FunctionType::UserDef),
-      params_(params), id_(id) {}
+      params_(params), param_tokens_(), param_slots_(), id_(id) {
+      for (const auto &unit : params_) {
+        auto token_id = TryAppendTokenId(unit);
+        param_tokens_.push_back(token_id);
+        param_slots_.push_back(code != nullptr ? code->FindSlots(token_id) : SlotGroup());
+      }
+    }
 
     template <typename _T>
     _T &Get() { return std::get<FunctionBase<_T>>(slot_).impl; }
 
+    //Body of user-defined function, shared by copies of this function
+    Bytecode *GetCode() { return Get<BytecodeHandle>().get(); }
+
     //Remove in the future, deprecated
     auto GetId() const { return id_; }
 
     auto IsVariableParam() const { return variable_param_; }
     auto &AccessParameters() { return params_; }
+    auto &AccessParameterTokens() { return param_tokens_; }
+    //slots of parameters inside body, filled on binding arguments
+    auto &AccessParameterSlots() { return param_slots_; }
     auto GetType() const { return type_; }
     auto GetParamSize() const { return params_.size(); }
     //auto &AccessClosureScope() { return scope_; }
-    auto GetOffset() const { return std::get<UserDefinedFunction>(slot_).offset; }
     auto Good() const { return (type_ != FunctionType::Invalid); }
 
     //bool Compare(Function &rhs) {
@@ -116,4 +129,6 @@ namespace sapphire {
   };
 
   using FunctionPointer = Function *;
+  template <>
+  inline constexpr CollectableKind kCollectableKind<Function> = CollectableKind::Function;
 }
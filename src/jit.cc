@@ -0,0 +1,315 @@
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define SAPPHIRE_JIT_X64
+#endif
+
+namespace sapphire {
+#ifdef SAPPHIRE_JIT_X64
+  size_t JitIndex(NativeRunner &runner) { return runner.Index(); }
+  bool JitResumable(NativeRunner &runner) { return runner.Resumable(); }
+  int64_t *JitIntOperand(NativeRunner &runner, Operand &arg) { return runner.IntOperand(arg); }
+  bool JitStep(NativeRunner &runner, size_t idx) { return runner.Step(idx); }
+  bool JitPushInt(NativeRunner &runner, size_t idx, int64_t value) { return runner.PushInt(idx, value); }
+  bool JitPushBool(NativeRunner &runner, size_t idx, bool value) { return runner.PushBool(idx, value); }
+  bool JitBranch(NativeRunner &runner, size_t idx, bool state) { return runner.Branch(idx, state); }
+
+  // Machine code writer, labels are patched as rel32 after their positions
+  // are known.
+  class X64Writer {
+  public:
+    vector<uint8_t> code;
+
+    void Bytes(initializer_list<uint8_t> bytes) {
+      code.insert(code.end(), bytes);
+    }
+
+    void Imm32(uint32_t value) {
+      for (size_t idx = 0; idx < 4; idx += 1) code.push_back((value >> (idx * 8)) & 0xff);
+    }
+
+    void Imm64(uint64_t value) {
+      for (size_t idx = 0; idx < 8; idx += 1) code.push_back((value >> (idx * 8)) & 0xff);
+    }
+
+    // returns position of rel32 field
+    size_t Jump(initializer_list<uint8_t> opcode) {
+      Bytes(opcode);
+      Imm32(0);
+      return code.size() - 4;
+    }
+
+    void Bind(size_t field, size_t target) {
+      auto rel = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(field + 4));
+      for (size_t idx = 0; idx < 4; idx += 1) code[field + idx] = (static_cast<uint32_t>(rel) >> (idx * 8)) & 0xff;
+    }
+
+    // rdi = runner, rax = function, call rax
+    void CallHelper(const void *func) {
+      Bytes({ 0x48, 0x89, 0xdf });
+      Bytes({ 0x48, 0xb8 });
+      Imm64(reinterpret_cast<uint64_t>(func));
+      Bytes({ 0xff, 0xd0 });
+    }
+
+    // rdi = runner, esi = command index, call function
+    void CallStep(const void *func, size_t idx) {
+      Bytes({ 0x48, 0x89, 0xdf });
+      Bytes({ 0xbe });
+      Imm32(static_cast<uint32_t>(idx));
+      Bytes({ 0x48, 0xb8 });
+      Imm64(reinterpret_cast<uint64_t>(func));
+      Bytes({ 0xff, 0xd0 });
+    }
+  };
+
+  // Integer operand which is known when block is compiled
+  bool IsIntLiteral(Operand &arg) {
+    return arg.fetch == FetchKind::Literal && arg.constant != nullptr &&
+      arg.constant->GetMode() == ObjectMode::Normal && arg.constant->IsUnboxed() &&
+      arg.constant->GetTypeHandle() == kTypeHandleInt;
+  }
+
+  bool IsIntOperand(Operand &arg) {
+    return arg.fetch == FetchKind::Named || IsIntLiteral(arg);
+  }
+
+  // Condition code of setcc for integer comparison, 0 if not supported
+  uint8_t GetConditionCode(Operation operation) {
+    switch (operation) {
+    case Operation::Equals: return 0x94;
+    case Operation::NotEqual: return 0x95;
+    case Operation::Less: return 0x9c;
+    case Operation::LessOrEqual: return 0x9e;
+    case Operation::Greater: return 0x9f;
+    case Operation::GreaterOrEqual: return 0x9d;
+    default: return 0;
+    }
+  }
+
+  enum class TemplateKind { None, Math, Compare, CompareBranch, IncreaseBy };
+
+  // Commands which have machine code template. Operand types are taken from
+  // quickening, they're guarded again when template is executed.
+  TemplateKind FindTemplate(Bytecode &code, Instruction &inst) {
+    if (inst.type != NodeType::Operation) return TemplateKind::None;
+
+    auto args = code.GetArguments(inst);
+
+    if (inst.operation == Operation::IncreaseBy) {
+      bool fit = inst.immediate >= std::numeric_limits<int32_t>::min() &&
+        inst.immediate <= std::numeric_limits<int32_t>::max();
+      return args.size() == 1 && args[0].fetch == FetchKind::Named && fit ?
+        TemplateKind::IncreaseBy : TemplateKind::None;
+    }
+
+    if (inst.quickened != kTypeHandleInt || args.size() != 2 ||
+      !IsIntOperand(args[0]) || !IsIntOperand(args[1])) {
+      return TemplateKind::None;
+    }
+
+    switch (inst.operation) {
+    case Operation::Plus:
+    case Operation::Minus:
+      return TemplateKind::Math;
+    case Operation::CompareBranch:
+      return GetConditionCode(inst.origin) != 0 ? TemplateKind::CompareBranch : TemplateKind::None;
+    default:
+      return GetConditionCode(inst.operation) != 0 ? TemplateKind::Compare : TemplateKind::None;
+    }
+  }
+
+  JitBlock::~JitBlock() {
+    munmap(memory_, size_);
+  }
+
+  bool IsJitSupported() { return true; }
+
+  // Loads integer operand into r12 (pos 0) or r13 (pos 1).
+  // Named operand is resolved by runner, jumps to fallback if it's not an
+  // unboxed integer.
+  void EmitIntOperand(X64Writer &writer, Operand &arg, size_t pos, vector<size_t> &to_fallback) {
+    if (IsIntLiteral(arg)) {
+      writer.Bytes({ 0x49, static_cast<uint8_t>(pos == 0 ? 0xbc : 0xbd) }); // mov r12/r13, imm64
+      writer.Imm64(static_cast<uint64_t>(arg.constant->Cast<int64_t>()));
+      return;
+    }
+
+    writer.Bytes({ 0x48, 0xbe });               // mov rsi, operand
+    writer.Imm64(reinterpret_cast<uint64_t>(&arg));
+    writer.CallHelper(reinterpret_cast<const void *>(JitIntOperand));
+    writer.Bytes({ 0x48, 0x85, 0xc0 });         // test rax, rax
+    to_fallback.push_back(writer.Jump({ 0x0f, 0x84 })); // jz fallback
+    writer.Bytes({ 0x4c, 0x8b, static_cast<uint8_t>(pos == 0 ? 0x20 : 0x28) }); // mov r12/r13, [rax]
+  }
+
+  // Machine code of command with template, result is handed to runner
+  // which finishes the command. Leaves al as the command entry does.
+  void EmitTemplate(X64Writer &writer, Bytecode &code, size_t idx, TemplateKind kind,
+    vector<size_t> &to_fallback) {
+    auto &inst = code[idx];
+    auto args = code.GetArguments(inst);
+
+    if (kind == TemplateKind::IncreaseBy) {
+      writer.Bytes({ 0x48, 0xbe });             // mov rsi, operand
+      writer.Imm64(reinterpret_cast<uint64_t>(&args[0]));
+      writer.CallHelper(reinterpret_cast<const void *>(JitIntOperand));
+      writer.Bytes({ 0x48, 0x85, 0xc0 });       // test rax, rax
+      to_fallback.push_back(writer.Jump({ 0x0f, 0x84 })); // jz fallback
+      writer.Bytes({ 0x48, 0x81, 0x00 });       // add qword [rax], imm32
+      writer.Imm32(static_cast<uint32_t>(inst.immediate));
+      writer.CallStep(reinterpret_cast<const void *>(JitStep), idx);
+      return;
+    }
+
+    EmitIntOperand(writer, args[0], 0, to_fallback);
+    EmitIntOperand(writer, args[1], 1, to_fallback);
+
+    if (kind == TemplateKind::Math) {
+      if (inst.operation == Operation::Plus) writer.Bytes({ 0x4d, 0x01, 0xec }); // add r12, r13
+      else writer.Bytes({ 0x4d, 0x29, 0xec });  // sub r12, r13
+      writer.Bytes({ 0x4c, 0x89, 0xe2 });       // mov rdx, r12
+      writer.CallStep(reinterpret_cast<const void *>(JitPushInt), idx);
+      return;
+    }
+
+    auto cc = GetConditionCode(kind == TemplateKind::CompareBranch ? inst.origin : inst.operation);
+
+    writer.Bytes({ 0x4d, 0x39, 0xec });         // cmp r12, r13
+    writer.Bytes({ 0x0f, cc, 0xc2 });           // setcc dl
+    writer.Bytes({ 0x0f, 0xb6, 0xd2 });         // movzx edx, dl
+    writer.CallStep(reinterpret_cast<const void *>(
+      kind == TemplateKind::CompareBranch ? JitBranch : JitPushBool), idx);
+  }
+
+  // Layout of compiled block, rbx holds the runner, r12/r13 hold operands
+  // of templates:
+  //   dispatch: switch on current index through jump table
+  //   case k:   machine code template of command, or call command entry,
+  //             then fall into case k + 1, or leave
+  //   resume:   dispatch again if block can be resumed
+  //   exit:     return to Run()
+  // Template jumps to command entry if its operands are not what the
+  // quickened command has seen, so types are always checked by interpreter.
+  void CompileNativeBlock(Bytecode &code) {
+    X64Writer writer;
+    vector<size_t> case_pos(code.size(), 0);
+    vector<size_t> to_resume, to_exit;
+    size_t count = code.size();
+    size_t dispatch = 0, resume = 0, exit = 0, table_field = 0;
+
+    if (count == 0 || count > std::numeric_limits<int32_t>::max()) return;
+
+    auto is_native = [&code](size_t idx) -> bool {
+      return code[idx].type == NodeType::Operation && GetNativeStep(code[idx].operation) != nullptr;
+    };
+
+    writer.Bytes({ 0x53 });                     // push rbx
+    writer.Bytes({ 0x41, 0x54 });               // push r12
+    writer.Bytes({ 0x41, 0x55 });               // push r13
+    writer.Bytes({ 0x48, 0x89, 0xfb });         // mov rbx, rdi
+
+    dispatch = writer.code.size();
+    writer.CallHelper(reinterpret_cast<const void *>(JitIndex));
+    writer.Bytes({ 0x48, 0x3d });               // cmp rax, count
+    writer.Imm32(static_cast<uint32_t>(count));
+    to_exit.push_back(writer.Jump({ 0x0f, 0x83 })); // jae exit
+    writer.Bytes({ 0x48, 0xb9 });               // mov rcx, table
+    table_field = writer.code.size();
+    writer.Imm64(0);
+    writer.Bytes({ 0xff, 0x24, 0xc1 });         // jmp [rcx + rax * 8]
+
+    bool has_case = false;
+
+    for (size_t idx = 0; idx < count; idx += 1) {
+      auto &inst = code[idx];
+
+      if (is_native(idx)) {
+        bool fallthrough = idx + 1 < count && is_native(idx + 1) && inst.operation != Operation::Fn;
+
+        auto kind = FindTemplate(code, inst);
+        size_t to_done = 0;
+
+        has_case = true;
+        case_pos[idx] = writer.code.size();
+
+        if (kind != TemplateKind::None) {
+          vector<size_t> to_fallback;
+          EmitTemplate(writer, code, idx, kind, to_fallback);
+          writer.Bytes({ 0x84, 0xc0 });         // test al, al
+          to_resume.push_back(writer.Jump({ 0x0f, 0x84 })); // jz resume
+          to_done = writer.Jump({ 0xe9 });      // jmp done
+          for (auto unit : to_fallback) writer.Bind(unit, writer.code.size());
+        }
+
+        writer.Bytes({ 0x48, 0x89, 0xdf });     // mov rdi, rbx
+        writer.Bytes({ 0xbe });                 // mov esi, idx
+        writer.Imm32(static_cast<uint32_t>(idx));
+        writer.Bytes({ 0x48, 0xb8 });           // mov rax, entry
+        writer.Imm64(reinterpret_cast<uint64_t>(GetNativeStep(inst.operation)));
+        writer.Bytes({ 0xff, 0xd0 });           // call rax
+        writer.Bytes({ 0x84, 0xc0 });           // test al, al
+        to_resume.push_back(writer.Jump({ 0x0f, 0x84 })); // jz resume
+        if (kind != TemplateKind::None) writer.Bind(to_done, writer.code.size());
+        if (!fallthrough) to_exit.push_back(writer.Jump({ 0xe9 })); // jmp exit
+      }
+
+      //function body is never executed in this block
+      if (inst.type == NodeType::Operation && inst.operation == Operation::Fn &&
+        inst.annotation.nest_end > idx) {
+        idx = inst.annotation.nest_end - 1;
+      }
+    }
+
+    if (!has_case) return;
+
+    resume = writer.code.size();
+    writer.CallHelper(reinterpret_cast<const void *>(JitResumable));
+    writer.Bytes({ 0x84, 0xc0 });               // test al, al
+    writer.Bind(writer.Jump({ 0x0f, 0x85 }), dispatch); // jnz dispatch
+
+    exit = writer.code.size();
+    writer.Bytes({ 0x41, 0x5d });               // pop r13
+    writer.Bytes({ 0x41, 0x5c });               // pop r12
+    writer.Bytes({ 0x5b, 0xc3 });               // pop rbx; ret
+
+    for (auto unit : to_resume) writer.Bind(unit, resume);
+    for (auto unit : to_exit) writer.Bind(unit, exit);
+
+    while (writer.code.size() % 8 != 0) writer.Bytes({ 0xcc });
+
+    size_t table = writer.code.size();
+    size_t size = table + count * sizeof(uint64_t);
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED) return;
+
+    auto base = reinterpret_cast<uint64_t>(memory);
+
+    for (size_t idx = 0; idx < count; idx += 1) {
+      writer.Imm64(base + (case_pos[idx] != 0 ? case_pos[idx] : exit));
+    }
+
+    for (size_t idx = 0; idx < 8; idx += 1) {
+      writer.code[table_field + idx] = ((base + table) >> (idx * 8)) & 0xff;
+    }
+
+    memcpy(memory, writer.code.data(), size);
+
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+      munmap(memory, size);
+      return;
+    }
+
+    auto block = make_shared<JitBlock>(memory, size);
+    code.AttachJitBlock(block, block->GetEntry());
+  }
+#else
+  JitBlock::~JitBlock() {}
+
+  bool IsJitSupported() { return false; }
+
+  void CompileNativeBlock(Bytecode &code) {}
+#endif
+}
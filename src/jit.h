@@ -0,0 +1,31 @@
+#pragma once
+#include "machine.h"
+
+namespace sapphire {
+  // Baseline JIT (--jit, Linux x86-64 only).
+  // Block which gets hot is compiled into a native block. Integer +/-,
+  // comparison, compare-and-branch and '+=' with literal on unboxed locals
+  // have machine code templates, guarded by operand types. Other commands
+  // and failed guards call command entry directly. Then it goes on to next
+  // command in place, every other case is left to interpreter.
+  const size_t kJitThreshold = 1000;
+
+  // Executable memory of one compiled block
+  class JitBlock {
+  protected:
+    void *memory_;
+    size_t size_;
+
+  public:
+    JitBlock() = delete;
+    JitBlock(const JitBlock &) = delete;
+    void operator=(const JitBlock &) = delete;
+    JitBlock(void *memory, size_t size) : memory_(memory), size_(size) {}
+    ~JitBlock();
+
+    NativeBlock GetEntry() const { return reinterpret_cast<NativeBlock>(memory_); }
+  };
+
+  bool IsJitSupported();
+  void CompileNativeBlock(Bytecode &code);
+}
@@ -66,6 +66,21 @@ namespace sapphire {
     Print,
     PrintLine,
     Sleep,
+    // Test of left operand of &&/||, only emitted by parser
+    ShortCircuit,
+    // Dropping names bound by inlined call, only emitted by optimizer
+    Unbind,
+    // Superinstructions, only emitted by bytecode compiler
+    CompareBranch,
+    IncreaseBy,
+    // Built-in container methods, only emitted by bytecode compiler
+    IntrinsicAt,
+    IntrinsicSize,
+    IntrinsicPush,
+    IntrinsicPop,
+    IntrinsicFind,
+    IntrinsicInsert,
+    IntrinsicEmpty,
     Null
   };
 
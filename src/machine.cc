@@ -1,97 +1,15 @@
 #include "machine.h"
+#include "optimizer.h"
+#include "jit.h"
+#include "collector.h"
 
 #define EXPECTED_COUNT(_Count) (args.size() == _Count)
 
-namespace sapphire {
-  inline PlainType FindTypeCode(string type_id) {
-    PlainType type = PlainType::Invalid;
-
-    if (type_id == kTypeIdInt) type = PlainType::Int;
-    if (type_id == kTypeIdFloat) type = PlainType::Float;
-    if (type_id == kTypeIdString) type = PlainType::String;
-    if (type_id == kTypeIdBool) type = PlainType::Bool;
-
-    return type;
-  }
-
-  inline bool IsIllegalStringOperator(Operation operation) {
-    return operation != Operation::Plus && operation != Operation::NotEqual
-      && operation != Operation::Equals;
-  }
-
-  inline int64_t IntProducer(Object &obj) {
-    int64_t result = 0;
-
-    if (obj.GetTypeId() == kTypeIdInt) {
-      result = obj.Cast<int64_t>();
-    }
-    else {
-      switch (auto type = FindTypeCode(obj.GetTypeId()); type) {
-      case PlainType::Float:result = static_cast<int64_t>(obj.Cast<double>()); break;
-      case PlainType::Bool:result = obj.Cast<bool>() ? 1 : 0; break;
-      default:break;
-      }
-    }
-
-    return result;
-  }
-
-  inline double FloatProducer(Object &obj) {
-    double result = 0;
-
-    if (obj.GetTypeId() == kTypeIdFloat) {
-      result = obj.Cast<double>();
-    }
-    else {
-      switch (auto type = FindTypeCode(obj.GetTypeId()); type) {
-      case PlainType::Int:result = static_cast<double>(obj.Cast<int64_t>()); break;
-      case PlainType::Bool:result = obj.Cast<bool>() ? 1.0 : 0.0; break;
-      default:break;
-      }
-    }
-
-    return result;
-  }
-
-  inline string StringProducer(Object &obj) {
-    string result;
-
-    if (obj.GetTypeId() == kTypeIdString) {
-      result = obj.Cast<string>();
-    }
-    else {
-      switch (auto type = FindTypeCode(obj.GetTypeId()); type) {
-      case PlainType::Float:result = to_string(obj.Cast<double>()); break;
-      case PlainType::Bool:result = obj.Cast<bool>() ? kStrTrue : kStrFalse; break;
-      case PlainType::Int:result = to_string(obj.Cast<int64_t>()); break;
-      default:break;
-      }
-    }
-
-    return result;
-  }
-
-  bool BoolProducer(Object &obj) {
-    if (obj.GetTypeId() == kTypeIdBool) {
-      return obj.Cast<bool>();
-    }
-
-    auto type = FindTypeCode(obj.GetTypeId());
-    bool result = false;
-
-
-    switch (type) {
-    case PlainType::Int: result = obj.Cast<int64_t>() > 0; break;
-    case PlainType::Float: result = obj.Cast<double>() > 0.0; break;
-    case PlainType::Bool: result = obj.Cast<bool>(); break;
-    case PlainType::String: result = !obj.Cast<string>().empty(); break;
-    default:
-      break;
-    }
+#if defined(SAPPHIRE_COMPUTED_GOTO) && (defined(__GNUC__) || defined(__clang__))
+#define SAPPHIRE_THREADED_DISPATCH
+#endif
 
-    return result;
-  }
-  
+namespace sapphire {
   string ParseRawString(const string & src) {
     string result = src;
     if (lexical::IsString(result)) result = lexical::GetRawString(result);
@@ -126,13 +44,72 @@ namespace sapphire {
     for (const auto func : kEmbeddedComponents) func();
   }
 
+  void FrameDetail::Reset() {
+    struct_base = Object();
+    assert_rc_copy = Object();
+    msg_string.clear();
+    struct_id.clear();
+    super_struct_id.clear();
+  }
+
+  // Keep allocated storage of stacks and detail for next calling
+  void RuntimeFrame::Reset() {
+    auto clear_stack = [](auto &dest) -> void {
+      while (!dest.empty()) dest.pop();
+    };
+
+    error = false;
+    warning = false;
+    from_continue = false;
+    from_break = false;
+    void_call = false;
+    disable_step = false;
+    final_cycle = false;
+    jump_from_end = false;
+    do_initializer_calling = false;
+    inside_initializer_calling = false;
+    stop_point = false;
+    has_return_value_from_invoking = false;
+    keep_condition = false;
+    is_command = false;
+    cmd_value_returned = false;
+    suspended = false;
+    iteration_stage = IterationStage::None;
+    current_code = nullptr;
+    idx = 0;
+    if (detail_ != nullptr) detail_->Reset();
+    clear_stack(condition_stack);
+    clear_stack(scope_indicator);
+    clear_stack(jump_stack);
+    clear_stack(branch_jump_stack);
+    return_stack.Clear();
+    slots.clear();
+  }
+
+  // Slot array follows code block of this frame, it's sized on first use
+  ObjectSlot &RuntimeFrame::GetSlot(Bytecode &code, size_t slot) {
+    if (slot >= slots.size()) slots.resize(code.CountSlots());
+    return slots[slot];
+  }
+
   void RuntimeFrame::Stepping() {
     if (!disable_step) idx += 1;
     disable_step = false;
   }
 
+  //returns false if error is occurred
+  bool RuntimeFrame::FinishCommand(bool is_return) {
+    if (error) return false;
+    if (!stop_point) Stepping();
+    if (!cmd_value_returned && !is_return) {
+      RefreshReturnStack(Object());
+    }
+    cmd_value_returned = false;
+    return true;
+  }
+
   void RuntimeFrame::Goto(size_t target_idx) {
-    idx = target_idx - jump_offset;
+    idx = target_idx;
     disable_step = true;
   }
 
@@ -144,17 +121,17 @@ namespace sapphire {
 
   void RuntimeFrame::MakeError(string str) {
     error = true;
-    msg_string = str;
+    Detail().msg_string = str;
   }
 
   void RuntimeFrame::MakeWarning(string str) {
     warning = true;
-    msg_string = str;
+    Detail().msg_string = str;
   }
 
   void RuntimeFrame::RefreshReturnStack(Object &obj) {
     if (!void_call) {
-      return_stack.push_back(new Object(obj));
+      return_stack.Push(obj);
       has_return_value_from_invoking = stop_point;
     }
 
@@ -163,7 +140,7 @@ namespace sapphire {
 
   void RuntimeFrame::RefreshReturnStack(Object &&obj) {
     if (!void_call) {
-      return_stack.push_back(new Object(std::move(obj)));
+      return_stack.Push(obj);
       has_return_value_from_invoking = stop_point;
     }
 
@@ -172,7 +149,7 @@ namespace sapphire {
 
   void RuntimeFrame::RefreshReturnStack(const ObjectInfo &info, const shared_ptr<void> &ptr) {
     if (!void_call) {
-      return_stack.push_back(new Object(info, ptr));
+      return_stack.Push(Object(info, ptr));
       has_return_value_from_invoking = stop_point;
     }
 
@@ -181,7 +158,7 @@ namespace sapphire {
   
   void RuntimeFrame::RefreshReturnStack(bool value) {
     if (!void_call) {
-      return_stack.push_back(new Object(value, kTypeIdBool));
+      return_stack.Push(Object(value, kTypeHandleBool));
       has_return_value_from_invoking = stop_point;
     }
     
@@ -190,7 +167,7 @@ namespace sapphire {
 
   void RuntimeFrame::RefreshReturnStack(ObjectView &&view) {
     if (!void_call) {
-      return_stack.push_back(new ObjectView(view));
+      return_stack.PushView(&view.Seek());
       has_return_value_from_invoking = stop_point;
     }
 
@@ -222,48 +199,15 @@ namespace sapphire {
     frame_stack_.top().RefreshReturnStack(instance_obj);
   }
 
-  bool AASTMachine::IsTailRecursion(size_t idx, AnnotatedAST *code) {
+  // Tail position is recorded by ASTOptimizer
+  bool AASTMachine::IsTailRecursion(size_t idx, Bytecode *code) {
     if (code != code_stack_.back()) return false;
-
-    auto &vmcode = *code;
-    auto &current = vmcode[idx];
-    bool result = false;
-
-    if (idx == vmcode.size() - 1) {
-      result = true;
-    }
-    else if (idx == vmcode.size() - 2) {
-      bool needed_by_next_call =
-        vmcode[idx + 1].first.GetOperation() == Operation::Return &&
-        vmcode[idx + 1].second.back().GetType() == ArgumentType::RetStack &&
-        vmcode[idx + 1].second.size() == 1;
-      if (!current.first.annotation.void_call && needed_by_next_call) {
-        result = true;
-      }
-    }
-
-    return result;
+    return (*code)[idx].annotation.tail_call;
   }
 
   bool AASTMachine::IsTailCall(size_t idx) {
     if (frame_stack_.size() <= 1) return false;
-    auto &vmcode = *code_stack_.back();
-    bool result = false;
-
-    if (idx == vmcode.size() - 1) {
-      result = true;
-    }
-    else if (idx == vmcode.size() - 2) {
-      bool needed_by_next_call = 
-        vmcode[idx + 1].first.GetOperation() == Operation::Return &&
-        vmcode[idx + 1].second.back().GetType() == ArgumentType::RetStack &&
-        vmcode[idx + 1].second.size() == 1;
-      if (!vmcode[idx].first.annotation.void_call && needed_by_next_call) {
-        result = true;
-      }
-    }
-
-    return result;
+    return (*code_stack_.back())[idx].annotation.tail_call;
   }
 
   Object *AASTMachine::FetchLiteralObject(Argument &arg) {
@@ -278,7 +222,7 @@ namespace sapphire {
     if (type == LiteralType::Int) {
       int64_t int_value;
       from_chars(value.data(), value.data() + value.size(), int_value);
-      ptr = CreateConstantObject(value, Object(int_value, kTypeIdInt));
+      ptr = CreateConstantObject(value, Object(int_value, kTypeHandleInt));
     }
     else if (type == LiteralType::Float) {
       double float_value;
@@ -288,12 +232,12 @@ namespace sapphire {
 #else
       from_chars(value.data(), value.data() + value.size(), float_value);
 #endif
-      ptr = CreateConstantObject(value, Object(float_value, kTypeIdFloat));
+      ptr = CreateConstantObject(value, Object(float_value, kTypeHandleFloat));
     }
     else {
       switch (type) {
       case LiteralType::Bool:
-        ptr = CreateConstantObject(value, Object(value == kStrTrue, kTypeIdBool));
+        ptr = CreateConstantObject(value, Object(value == kStrTrue, kTypeHandleBool));
         break;
       case LiteralType::String:
         ptr = CreateConstantObject(value, Object(ParseRawString(value)));
@@ -310,7 +254,7 @@ namespace sapphire {
     return ptr;
   }
 
-  ObjectView AASTMachine::FetchObjectView(Argument &arg) {
+  ObjectView AASTMachine::FetchObjectView(Operand &arg) {
     using namespace constant;
 
 #define OBJECT_DEAD_MSG {                           \
@@ -328,82 +272,76 @@ namespace sapphire {
     ObjectPointer ptr = nullptr;
     ObjectView view;
 
-    if (arg.GetType() == ArgumentType::Literal) {
-      view = FetchLiteralObject(arg);
+    switch (arg.fetch) {
+    case FetchKind::Literal:
+      view = arg.constant != nullptr ? arg.constant : FetchLiteralObject(arg);
       view.source = ObjectViewSource::Literal;
-    }
-    else if (arg.GetType() == ArgumentType::Pool) {
-      if (!arg.properties.domain.id.empty() || arg.properties.member_access.use_last_assert) {
-        if (arg.properties.member_access.use_last_assert) {
-          auto &base = frame.assert_rc_copy.Cast<ObjectStruct>();
-          ptr = base.Find(arg.GetData());
+      break;
+    case FetchKind::Named:
+      if (ptr = FindNamedObject(arg); ptr != nullptr) {
+        if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
+        view = ObjectView(ptr);
+      }
+      else {
+        frame.MakeError("Object is not found: " + arg.GetData());
+      }
+      view.source = ObjectViewSource::Ref;
+      break;
+    case FetchKind::LastAssert: {
+      auto &base = frame.Detail().assert_rc_copy.Cast<ObjectStruct>();
+      ptr = base.FindMember(arg.GetData(), arg.member);
 
-          if (ptr != nullptr) {
-            if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
-            view = ObjectView(ptr);
-          }
-          else MEMBER_NOT_FOUND_MSG;
+      if (ptr != nullptr) {
+        if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
+        view = ObjectView(ptr);
+      }
+      else MEMBER_NOT_FOUND_MSG;
 
-          if (arg.properties.member_access.is_chain_tail) frame.assert_rc_copy = Object();
-        }
-        else if (arg.properties.domain.type == ArgumentType::Pool) {
-          ptr = obj_stack_.Find(arg.GetData(), arg.properties.domain.id, arg.properties.token_id);
+      if (arg.properties.member_access.is_chain_tail) frame.Detail().assert_rc_copy = Object();
+      view.source = ObjectViewSource::Ref;
+      break;
+    }
+    case FetchKind::Member:
+      ptr = FindMemberObject(arg);
 
-          if (ptr != nullptr) {
-            if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
-            view = ObjectView(ptr);
-          }
-          else MEMBER_NOT_FOUND_MSG;
-        }
-        else if (arg.properties.domain.type == ArgumentType::RetStack) {
-          auto &sub_container = return_stack.back()->IsObjectView() ?
-            dynamic_cast<ObjectView *>(return_stack.back())->Seek().Cast<ObjectStruct>() :
-            dynamic_cast<ObjectPointer>(return_stack.back())->Cast<ObjectStruct>();
-          ptr = sub_container.Find(arg.GetData());
-          //keep object alive
-          if (ptr != nullptr) {
-            if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
-            view_delegator_.emplace_back(new Object(*ptr));
-            view = ObjectView(dynamic_cast<ObjectPointer>(view_delegator_.back()));
-            delete return_stack.back();
-            return_stack.pop_back();
-          }
-          else MEMBER_NOT_FOUND_MSG;
-        }
+      if (ptr != nullptr) {
+        if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
+        view = ObjectView(ptr);
       }
-      else {
-        if (ptr = obj_stack_.Find(arg.GetData(), arg.properties.token_id); ptr != nullptr) {
-          if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
-          view = ObjectView(ptr);
-        }
-        else if (ptr = GetConstantObject(arg.GetData()); ptr != nullptr) {
-          view = ObjectView(ptr);
-        }
-        else {
-          frame.MakeError("Object is not found: " + arg.GetData());
-        }
+      else MEMBER_NOT_FOUND_MSG;
+      view.source = ObjectViewSource::Ref;
+      break;
+    case FetchKind::ChainMember: {
+      auto &sub_container = return_stack.back().Seek().Cast<ObjectStruct>();
+      ptr = sub_container.FindMember(arg.GetData(), arg.member);
+      //keep object alive
+      if (ptr != nullptr) {
+        if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
+        view_delegator_.emplace_back(*ptr);
+        view = ObjectView(&view_delegator_.back());
+        return_stack.pop_back();
       }
+      else MEMBER_NOT_FOUND_MSG;
       view.source = ObjectViewSource::Ref;
+      break;
     }
-    else if (arg.GetType() == ArgumentType::RetStack) {
+    case FetchKind::Unresolved:
+      view.source = ObjectViewSource::Ref;
+      break;
+    case FetchKind::RetStack:
       if (!return_stack.empty()) {
-        if (!return_stack.back()->IsAlive()) OBJECT_DEAD_MSG;
-        view_delegator_.emplace_back(return_stack.back());
-        if (view_delegator_.back()->IsObjectView()) {
-          view = *dynamic_cast<ObjectView *>(view_delegator_.back());
-        }
-        else {
-          view = ObjectView(
-            dynamic_cast<ObjectPointer>(view_delegator_.back()));
-          view.Seek().SeekDeliveringFlag();
-        }
-        
+        auto &top = return_stack.back();
+        if (!top.IsAlive()) OBJECT_DEAD_MSG;
+        view = ObjectView(&top.Seek());
         return_stack.pop_back();
       }
       else {
         frame.MakeError("Can't get object from stack(Internal error)");
       }
       view.source = ObjectViewSource::Ref;
+      break;
+    default:
+      break;
     }
 
 #undef OBJECT_DEAD_MSG
@@ -411,6 +349,67 @@ namespace sapphire {
     return view;
   }
 
+  // Resolving identifier via slot of current calling.
+  // Scope chain and constants are searched only if slot is out of date.
+  ObjectPointer AASTMachine::FindNamedObject(Operand &arg, bool binding_target) {
+    auto &id = arg.GetData();
+    auto token_id = arg.properties.token_id;
+    auto find = [&]() -> ObjectPointer {
+      if (binding_target) return obj_stack_.Find(id);
+      auto *ptr = obj_stack_.Find(id, token_id);
+      if (ptr != nullptr) return ptr;
+      return arg.constant != nullptr ? arg.constant : constant::GetConstantObject(id);
+    };
+
+    if (arg.slot == kNoSlot || token_id == 0) return find();
+
+    auto &slot = frame_stack_.top().GetSlot(*code_stack_.back(), arg.slot);
+    auto version = GetBindingVersion(token_id);
+    auto scope = obj_stack_.GetScopeSerial();
+
+    if (!slot.IsValid(version, scope)) {
+      slot.Fill(find(), version, scope);
+    }
+
+    return slot.ptr;
+  }
+
+  // Resolving a.b, domain object comes from slot of current calling
+  // and member is loaded from slot of struct shape if shape is unchanged.
+  ObjectPointer AASTMachine::FindMemberObject(Operand &arg) {
+    auto &domain_id = arg.properties.domain.id;
+    auto token_id = arg.properties.token_id;
+    ObjectPointer domain = nullptr;
+
+    if (arg.slot == kNoSlot || token_id == 0) {
+      domain = obj_stack_.Find(domain_id, token_id);
+    }
+    else {
+      auto &slot = frame_stack_.top().GetSlot(*code_stack_.back(), arg.slot);
+      auto version = GetBindingVersion(token_id);
+      auto scope = obj_stack_.GetScopeSerial();
+
+      if (!slot.IsValid(version, scope)) {
+        slot.Fill(obj_stack_.Find(domain_id, token_id), version, scope);
+      }
+
+      domain = slot.ptr;
+    }
+
+    ObjectPointer ptr = nullptr;
+
+    if (domain != nullptr && domain->IsSubContainer()) {
+      ptr = domain->Cast<ObjectStruct>().FindMember(arg.GetData(), arg.member);
+    }
+
+    //outer object stack
+    if (ptr == nullptr) {
+      ptr = obj_stack_.Find(arg.GetData(), domain_id, token_id);
+    }
+
+    return ptr;
+  }
+
   bool AASTMachine::CheckObjectBehavior(Object &obj, string behaviors) {
     auto sample = BuildStringVector(behaviors);
     bool result = true;
@@ -420,7 +419,7 @@ namespace sapphire {
         auto ptr = base.Find(unit);
 
         if (ptr == nullptr) result = false;
-        else if (ptr->GetTypeId() != kTypeIdFunction) result = false;
+        else if (ptr->GetTypeHandle() != kTypeHandleFunction) result = false;
 
         if (!result) return;
       }
@@ -450,14 +449,14 @@ namespace sapphire {
     if (obj.IsSubContainer()) {
       auto &base = obj.Cast<ObjectStruct>();
       auto ptr = base.Find(id);
-      result = (ptr != nullptr && ptr->GetTypeId() == kTypeIdFunction);
+      result = (ptr != nullptr && ptr->GetTypeHandle() == kTypeHandleFunction);
     }
     else {
       auto *struct_obj_ptr = obj_stack_.Find(obj.GetTypeId(), TryAppendTokenId(obj.GetTypeId()));
       if (struct_obj_ptr != nullptr && struct_obj_ptr->IsSubContainer()) {
         auto &base = struct_obj_ptr->Cast<ObjectStruct>();
         auto ptr = base.Find(id);
-        result = (ptr != nullptr && ptr->GetTypeId() == kTypeIdFunction);
+        result = (ptr != nullptr && ptr->GetTypeHandle() == kTypeHandleFunction);
       }
     }
 
@@ -499,21 +498,21 @@ namespace sapphire {
         }();
 
         if (result == nullptr) METHOD_NOT_FOUND_MSG;
-        if (result->GetTypeId() != kTypeIdFunction) TYPE_ERROR_MSG;
+        if (result->GetTypeHandle() != kTypeHandleFunction) TYPE_ERROR_MSG;
 
         dest = &result->Cast<Function>();
       }
       else {
         auto *result = struct_obj_ptr->Cast<ObjectStruct>().Find(func_id);
         if (result == nullptr) METHOD_NOT_FOUND_MSG;
-        if (result->GetTypeId() != kTypeIdFunction) TYPE_ERROR_MSG;
+        if (result->GetTypeHandle() != kTypeHandleFunction) TYPE_ERROR_MSG;
 
         dest = &result->Cast<Function>();
       }
     }
     else {
       if (auto *ptr = obj_stack_.Find(func_id); ptr != nullptr) {
-        if (ptr->GetTypeId() != kTypeIdFunction) TYPE_ERROR_MSG;
+        if (ptr->GetTypeHandle() != kTypeHandleFunction) TYPE_ERROR_MSG;
         dest = &ptr->Cast<Function>();
       }
       //Hint: behavior of initializer?
@@ -529,30 +528,71 @@ namespace sapphire {
 
   bool AASTMachine::FetchFunctionImpl(FunctionPointer &impl, CommandPointer &command, ObjectMap &obj_map) {
     auto &frame = frame_stack_.top();
-    auto id = command->first.GetFunctionId();
-    auto domain = command->first.GetFunctionDomain();
+    auto &site = code_stack_.back()->GetCallSite(*command);
+    auto &id = site.id;
+    auto &domain = site.domain;
 
     auto has_domain = domain.GetType() != ArgumentType::Invalid ||
-      command->first.annotation.use_last_assert;
+      command->annotation.use_last_assert;
 
     if (has_domain) {
-      auto view = command->first.annotation.use_last_assert ?
-        ObjectView(&frame.assert_rc_copy) :
+      auto view = command->annotation.use_last_assert ?
+        ObjectView(&frame.Detail().assert_rc_copy) :
         FetchObjectView(domain);
 
       if (frame.error) return false;
       //find method in sub-container    
 
-      auto struct_obj_ptr = obj_stack_.Find(view.Seek().GetTypeId());
+      auto &cache = site.GetMethodCache(view.Seek().GetTypeHandle());
+      auto &type_id = GetTypeName(cache.type);
+      auto scope = obj_stack_.GetScopeSerial();
+      auto method_version = GetBindingVersion(site.token_id);
+      auto struct_version = GetBindingVersion(cache.type_token);
+
+      if (!cache.struct_slot.IsValid(struct_version, cache.struct_global ? 0 : scope)) {
+        auto *ptr = obj_stack_.Find(type_id);
+        auto &base = obj_stack_.GetBase();
+        cache.struct_global = ptr != nullptr && !HasLocalBinding(cache.type_token) && 
+          !base.empty() && base.front().Find(type_id, false) == ptr;
+        cache.struct_slot.Fill(ptr, struct_version, cache.struct_global ? 0 : scope);
+      }
+
+      auto struct_obj_ptr = cache.struct_slot.ptr;
 
       if (struct_obj_ptr == nullptr || !struct_obj_ptr->IsSubContainer()) {
-        frame.MakeError("invalid base type of object: " + view.Seek().GetTypeId());
+        frame.MakeError("invalid base type of object: " + type_id);
         return false;
       }
 
-      auto *base_result = view.Seek().IsSubContainer() ?
-        view.Seek().Cast<ObjectStruct>().Find(id) : nullptr;
-      auto *struct_result = struct_obj_ptr->Cast<ObjectStruct>().Find(id);
+      auto &struct_base = struct_obj_ptr->Cast<ObjectStruct>();
+
+      if (cache.struct_serial != struct_base.GetSerial() || cache.struct_version != method_version) {
+        cache.struct_method = struct_base.Find(id);
+        cache.struct_serial = struct_base.GetSerial();
+        cache.struct_version = method_version;
+      }
+
+      ObjectPointer base_result = nullptr;
+
+      if (view.Seek().IsSubContainer()) {
+        auto &instance = view.Seek().Cast<ObjectStruct>();
+
+        //method table of shape is indexed directly
+        if (instance.GetShape() != nullptr) {
+          base_result = instance.FindMember(id, cache.instance_member);
+        }
+        else {
+          if (cache.instance_serial != instance.GetSerial() || cache.instance_version != method_version) {
+            cache.instance_method = instance.Find(id);
+            cache.instance_serial = instance.GetSerial();
+            cache.instance_version = method_version;
+          }
+
+          base_result = cache.instance_method;
+        }
+      }
+
+      auto *struct_result = cache.struct_method;
       auto *result = [&base_result, &struct_result]() -> auto {
         if (base_result != nullptr) return base_result;
         if (struct_result != nullptr) return struct_result;
@@ -564,7 +604,7 @@ namespace sapphire {
         return false;                                  
       }
 
-      if (result->GetTypeId() != kTypeIdFunction) {
+      if (result->GetTypeHandle() != kTypeHandleFunction) {
         frame.MakeError(id + " is not a function object");
         return false;
       }
@@ -573,11 +613,18 @@ namespace sapphire {
       
 
       obj_map.emplace(NamedObject(kStrMe, view.Seek()));
-      if (!frame.assert_rc_copy.NullPtr()) frame.assert_rc_copy = Object();
+      if (frame.HasAssertedObject()) frame.Detail().assert_rc_copy = Object();
     }
     //Plain bulit-in function and user-defined function
     else {
-      ObjectPointer ptr = obj_stack_.Find(id);
+      auto version = GetBindingVersion(site.token_id);
+      auto scope = obj_stack_.GetScopeSerial();
+
+      if (!site.callee.IsValid(version, scope)) {
+        site.callee.Fill(obj_stack_.Find(id), version, scope);
+      }
+
+      ObjectPointer ptr = site.callee.ptr;
 
       if (ptr == nullptr) {
         frame.MakeError("Function is not found: " + id);
@@ -589,10 +636,10 @@ namespace sapphire {
         return false;
       }
 
-      if (ptr->GetTypeId() == kTypeIdFunction) {
+      if (ptr->GetTypeHandle() == kTypeHandleFunction) {
         impl = &ptr->Cast<Function>();
       }
-      else if (ptr->IsSubContainer() && ptr->GetTypeId() == kTypeIdStruct) {
+      else if (ptr->IsSubContainer() && ptr->GetTypeHandle() == kTypeHandleStruct) {
         auto &base = ptr->Cast<ObjectStruct>();
         auto *initializer_obj = base.Find(kStrInitializer);
 
@@ -604,7 +651,7 @@ namespace sapphire {
         impl = &initializer_obj->Cast<Function>();
         if (impl->GetType() == FunctionType::UserDef) {
           frame.do_initializer_calling = true;
-          frame.struct_base = *ptr;
+          frame.Detail().struct_base = *ptr;
         }
       }
       else {
@@ -617,18 +664,19 @@ namespace sapphire {
     return true;
   }
 
-  void AASTMachine::CheckObjectWithDomain(Function &impl, ASTNode &node, bool first_assert) {
+  void AASTMachine::CheckObjectWithDomain(Function &impl, Instruction &inst, CallSite &site, 
+    bool first_assert) {
     auto &frame = frame_stack_.top();
-    auto domain = node.GetFunctionDomain();
-    auto operation = node.GetOperation();
+    auto &domain = site.domain;
+    auto operation = inst.operation;
     auto need_catching = domain.GetType() == ArgumentType::Pool
       && ((operation != Operation::DomainAssertCommand)
         || (operation == Operation::DomainAssertCommand && first_assert));
 
     if (!need_catching) return;
     
-    auto view = node.annotation.use_last_assert ?
-      ObjectView(&frame.assert_rc_copy) :
+    auto view = inst.annotation.use_last_assert ?
+      ObjectView(&frame.Detail().assert_rc_copy) :
       FetchObjectView(domain);
 
     if (frame.error) return;
@@ -636,7 +684,7 @@ namespace sapphire {
     impl.scope.insert(make_pair(domain.GetData(), components::DumpObject(view.Seek())));
   }
 
-  void AASTMachine::CheckArgrumentList(Function &impl, ArgumentList &args) {
+  void AASTMachine::CheckArgrumentList(Function &impl, ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     string_view data;
     ArgumentType type;
@@ -671,7 +719,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::ClosureCatching(ArgumentList &args, size_t nest_end, bool closure) {
+  void AASTMachine::ClosureCatching(ArgumentSpan &args, size_t nest_end, bool closure) {
     auto &frame = frame_stack_.top();
     auto &obj_list = obj_stack_.GetBase();
     auto &origin_code = *code_stack_.back();
@@ -682,15 +730,12 @@ namespace sapphire {
     bool first_assert = false;
     ParameterPattern argument_mode = ParameterPattern::Fixed;
     vector<string> params;
-    AnnotatedAST code(&origin_code);
+    auto body = origin_code.GetFunctionBody(nest, nest_end);
+    auto &code = *body;
     string return_value_constraint;
     auto &container = obj_stack_.GetCurrent();
     auto func_id = args[0].GetData();
 
-    for (size_t idx = nest + 1; idx < nest_end - frame.jump_offset; ++idx) {
-      code.push_back(origin_code[idx]);
-    }
-
     for (size_t idx = 1; idx < size; idx += 1) {
       auto id = args[idx].GetData();
 
@@ -705,16 +750,19 @@ namespace sapphire {
     }
 
 
-    Function impl(nest + 1, code, args[0].GetData(), params, variable);
+    Function impl(body, args[0].GetData(), params, variable);
 
     if (closure) {
       for (auto it = code.begin(); it != code.end(); ++it) {
         //needed for CheckObjectWithDomain() for judging catching or not
-        first_assert = not_assert_lastloop && it->first.GetOperation() == Operation::DomainAssertCommand;
-        not_assert_lastloop = it->first.GetOperation() != Operation::DomainAssertCommand;
+        first_assert = not_assert_lastloop && it->operation == Operation::DomainAssertCommand;
+        not_assert_lastloop = it->operation != Operation::DomainAssertCommand;
         //check and push target object into closure scope
-        CheckObjectWithDomain(impl, it->first, first_assert);
-        CheckArgrumentList(impl, it->second);
+        if (it->HasCallSite()) {
+          CheckObjectWithDomain(impl, *it, code.GetCallSite(*it), first_assert);
+        }
+        auto inst_args = code.GetArguments(*it);
+        CheckArgrumentList(impl, inst_args);
       }
     }
 
@@ -728,7 +776,7 @@ namespace sapphire {
       return;
     }
     else {
-      container.Add(func_id, Object(make_shared<Function>(impl), kTypeIdFunction),
+      container.Add(func_id, Object(make_shared<Function>(impl), kTypeHandleFunction),
         TryAppendTokenId(func_id));
     }
 
@@ -762,10 +810,8 @@ namespace sapphire {
       case 2: frame.MakeError(state.GetMsg()); break;
       default: 
         if (state.HasValueReturned()) {
-          result = frame.return_stack.back()->IsObjectView() ?
-            Object().PackObject(dynamic_cast<ObjectView *>(frame.return_stack.back())->Seek()) :
-            *dynamic_cast<ObjectPointer>(frame.return_stack.back());
-          delete frame.return_stack.back();
+          auto &top = frame.return_stack.back();
+          result = top.IsObjectView() ? Object().PackObject(top.Seek()) : top.value;
           frame.return_stack.pop_back();
         }
         break;
@@ -788,15 +834,22 @@ namespace sapphire {
       return std::nullopt;
     }
 
+    if (!CheckCallDepth()) return std::nullopt;
+
+    if (native_depth_ >= kNativeCallDepthMax) {
+      frame.MakeError("Maximum depth of native calling is exceeded");
+      return std::nullopt;
+    }
+
     frame.stop_point = true;
-    code_stack_.push_back(&impl.Get<AnnotatedAST>());
-    frame_stack_.push(RuntimeFrame(impl.GetId()));
-    frame_stack_.top().jump_offset = impl.GetOffset();
+    code_stack_.push_back(impl.GetCode());
+    frame_stack_.push();
     obj_stack_.Push();
-    obj_stack_.CreateObject(kStrUserFunc, Object(impl.GetId()));
-    obj_stack_.MergeMap(obj_map);
-    obj_stack_.MergeMap(impl.scope);
+    CallArguments arg_list;
+    BindCallScope(impl, obj_map, arg_list);
+    native_depth_ += 1;
     Run(true);
+    native_depth_ -= 1;
 
     if (error_) {
       frame.MakeError("Error occurred while calling user-defined function");
@@ -805,10 +858,8 @@ namespace sapphire {
 
     optional<Object> result;
     if (frame.has_return_value_from_invoking) {
-      result = frame.return_stack.back()->IsObjectView() ?
-        Object().PackObject(dynamic_cast<ObjectView *>(frame.return_stack.back())->Seek()) :
-        *dynamic_cast<ObjectPointer>(frame.return_stack.back());
-      delete frame.return_stack.back();
+      auto &top = frame.return_stack.back();
+      result = top.IsObjectView() ? Object().PackObject(top.Seek()) : top.value;
       frame.return_stack.pop_back();
     }
 
@@ -816,64 +867,422 @@ namespace sapphire {
     return result;
   }
 
-  void AASTMachine::CommandLoad(ArgumentList &args) {
+  // Script method invoked by native operation without entering Run() again.
+  // Callee frame is pushed onto running loop and current operation is
+  // suspended. Callee returns to this frame like a normal calling, then
+  // ResumeOperation() finishes the operation with its result.
+  // Component methods are still called directly and return their result.
+  optional<Object> AASTMachine::InvokeMethod(Object &obj, string id, ObjectMap &args) {
+    FunctionPointer impl;
+    auto &frame = frame_stack_.top();
+
+    if (!FetchFunctionImplEx(impl, id, obj.GetTypeId(), &obj)) return std::nullopt;
+    if (impl->GetType() != FunctionType::UserDef) return CallMethod2(obj, id, args);
+    if (!CheckCallDepth()) return std::nullopt;
+
+    ObjectMap obj_map = args;
+    CallArguments arg_list;
+    obj_map.emplace(NamedObject(kStrMe, obj));
+
+    //result is always taken, restored by ResumeOperation()
+    frame.void_call = false;
+    frame.suspended = true;
+    code_stack_.push_back(impl->GetCode());
+    frame_stack_.push();
+    obj_stack_.Push();
+    BindCallScope(*impl, obj_map, arg_list);
+    return std::nullopt;
+  }
+
+  optional<Object> AASTMachine::InvokeMethod(Object &obj, string id, const initializer_list<NamedObject> &&args) {
+    ObjectMap obj_map = args;
+    return InvokeMethod(obj, id, obj_map);
+  }
+
+  // Second half of operation suspended by InvokeMethod(). Result of script
+  // method is on top of return stack.
+  void AASTMachine::ResumeOperation() {
+    auto &frame = frame_stack_.top();
+    auto &code = *code_stack_.back();
+    auto &inst = code[frame.idx];
+    optional<Object> result;
+    bool value = false;
+
+    frame.suspended = false;
+    frame.void_call = inst.annotation.void_call;
+    frame.cmd_value_returned = false;
+
+    if (!frame.return_stack.empty()) {
+      auto &top = frame.return_stack.back();
+      result = top.IsObjectView() ? Object().PackObject(top.Seek()) : top.value;
+      frame.return_stack.pop_back();
+    }
+
+    switch (inst.operation) {
+    case Operation::Equals:
+    case Operation::NotEqual:
+      if (!FetchCompareResult(result, inst.operation, value)) return;
+      frame.RefreshReturnStack(value);
+      break;
+    case Operation::CompareBranch: {
+      if (!FetchCompareResult(result, inst.origin, value)) return;
+      frame.idx += 1;
+      auto &branch = code[frame.idx];
+      ConditionBranch(branch.operation, value, branch.annotation.nest_end);
+      break;
+    }
+    case Operation::For:
+      IterateScriptContainer(frame.iteration_stage, result);
+      //waiting for next method of container
+      if (frame.suspended) return;
+      break;
+    case Operation::PrintLine:
+      fputs("\n", VM_STDOUT);
+      break;
+    case Operation::IntrinsicAt:
+    case Operation::IntrinsicSize:
+    case Operation::IntrinsicPush:
+    case Operation::IntrinsicPop:
+    case Operation::IntrinsicFind:
+    case Operation::IntrinsicInsert:
+    case Operation::IntrinsicEmpty:
+      if (result.has_value()) frame.RefreshReturnStack(result.value());
+      break;
+    default:
+      break;
+    }
+
+    if (frame.error) return;
+    if (!frame.cmd_value_returned) frame.RefreshReturnStack(Object());
+    frame.cmd_value_returned = false;
+  }
+
+  bool AASTMachine::FetchCompareResult(optional<Object> &result, Operation operation, bool &value) {
+    if (!result.has_value() || result.value().GetTypeHandle() != kTypeHandleBool) {
+      frame_stack_.top().MakeError("Invalid behavior of compare()");
+      return false;
+    }
+
+    value = result.value().Cast<bool>();
+    if (operation == Operation::NotEqual) value = !value;
+    return true;
+  }
+
+  bool AASTMachine::CheckCallDepth() {
+    if (frame_stack_.size() < runtime::GetCallDepthLimit()) return true;
+    frame_stack_.top().MakeError("Maximum call depth is exceeded");
+    return false;
+  }
+
+  void AASTMachine::CommandLoad(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     auto view = FetchObjectView(args[0]);
     if (frame.error) return;
     frame.RefreshReturnStack(std::move(view));
   }
 
-  void AASTMachine::CommandIfOrWhile(Operation operation, ArgumentList &args, size_t nest_end) {
+  void AASTMachine::CommandIfOrWhile(Operation operation, ArgumentSpan &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
-    auto &code = code_stack_.front();
-    bool has_jump_record = false;
-    bool state = false;
 
     if (!EXPECTED_COUNT(1)) {
       frame.MakeError("Argument for condition is missing");
       return;
     }
 
-    if (operation == Operation::If || operation == Operation::While) {
-      frame.AddJumpRecord(nest_end);
-      has_jump_record = code->FindJumpRecord(frame.idx + frame.jump_offset, frame.branch_jump_stack);
-    }
-    
-
     ObjectView view = FetchObjectView(args[0]);
 
     if (frame.error) return;
 
-    if (view.Seek().GetTypeId() != kTypeIdBool) {
+    if (view.Seek().GetTypeHandle() != kTypeHandleBool) {
       frame.MakeError("Invalid state value type.");
       return;
     }
 
-    state = view.Seek().Cast<bool>();
+    ConditionBranch(operation, view.Seek().Cast<bool>(), nest_end);
+  }
 
-    if (operation == Operation::If) {
-      auto create_env = [&]()->void {
-        frame.scope_indicator.push(true);
-        frame.condition_stack.push(state);
-        obj_stack_.Push(true, true);
-      };
+  // Fused comparison and if/elif/while.
+  // Branch instruction right behind this one is executed with the result of
+  // comparison, without pushing it onto return stack.
+  void AASTMachine::CommandCompareBranch(Instruction &inst, ArgumentSpan &args) {
+    auto &frame = frame_stack_.top();
+    auto &code = code_stack_.back();
+    bool state = false;
+    bool good = false;
 
-      if (!state) {
-        if (frame.branch_jump_stack.empty()) {
-          frame.Goto(frame.jump_stack.top());
-          frame.keep_condition = true;
-        }
-        else {
-          create_env();
-          frame.Goto(frame.branch_jump_stack.top());
-          frame.branch_jump_stack.pop();
+    switch (inst.origin) {
+    case Operation::Equals: good = CompareOperands<Operation::Equals>(inst, args, state); break;
+    case Operation::NotEqual: good = CompareOperands<Operation::NotEqual>(inst, args, state); break;
+    case Operation::Less: good = CompareOperands<Operation::Less>(inst, args, state); break;
+    case Operation::LessOrEqual: good = CompareOperands<Operation::LessOrEqual>(inst, args, state); break;
+    case Operation::Greater: good = CompareOperands<Operation::Greater>(inst, args, state); break;
+    case Operation::GreaterOrEqual: good = CompareOperands<Operation::GreaterOrEqual>(inst, args, state); break;
+    default: break;
+    }
+
+    if (!good) return;
+
+    frame.idx += 1;
+    auto &branch = (*code)[frame.idx];
+    ConditionBranch(branch.operation, state, branch.annotation.nest_end);
+  }
+
+  // Left operand of &&/||. If it decides the result, right operand and the
+  // operator node are skipped and the result is left as operator node would
+  // do. Otherwise it's handed to operator node through return stack.
+  void AASTMachine::CommandShortCircuit(ArgumentSpan &args, size_t nest_end) {
+    auto &frame = frame_stack_.top();
+    auto &code = *code_stack_.back();
+
+    if (!EXPECTED_COUNT(1)) {
+      frame.MakeError("Argument behind operator is missing");
+      return;
+    }
+
+    auto view = FetchObjectView(args[0]);
+    if (frame.error) return;
+
+    if (view.Seek().GetTypeHandle() == kTypeHandleBool) {
+      bool value = view.Seek().Cast<bool>();
+
+      if (nest_end > 0 && nest_end <= code.size()) {
+        auto &target = code[nest_end - 1];
+        bool decided = (target.operation == Operation::And && !value) ||
+          (target.operation == Operation::Or && value);
+
+        if (decided) {
+          frame.void_call = target.annotation.void_call;
+          frame.RefreshReturnStack(value);
+          frame.Goto(nest_end);
+          return;
         }
       }
-      else {
-        create_env();
-      }
+
+      frame.RefreshReturnStack(value);
+      return;
     }
-    else if (operation == Operation::Elif) {
+
+    Object obj = view.Seek();
+    frame.RefreshReturnStack(obj);
+  }
+
+  // Names bound by ASTOptimizer::ExpandCall() are dropped once the value of
+  // inlined body is on return stack, so they don't outlive the call.
+  void AASTMachine::CommandUnbind(ArgumentSpan &args) {
+    auto &container = obj_stack_.GetCurrent();
+
+    for (auto &unit : args) {
+      container.Erase(string(unit.GetData()), unit.properties.token_id);
+    }
+  }
+
+  // Built-in container methods without method lookup and argument map.
+  // Arguments are fetched in the same order as method calling. Receiver of
+  // other types takes method calling.
+  template <Operation op>
+  void AASTMachine::CommandIntrinsic(Instruction &inst, ArgumentSpan &args) {
+    using components::DumpObject;
+    auto &frame = frame_stack_.top();
+    auto receiver = FetchObjectView(code_stack_.back()->GetCallSite(inst).domain);
+
+    if (frame.error) return;
+
+    auto &me = receiver.Seek();
+    auto type = me.GetTypeHandle();
+    auto fetch = [&](size_t idx) -> Object & {
+      auto view = FetchObjectView(args[idx]);
+      return frame.error ? me : view.Seek().RemoveDeliveringFlag();
+    };
+
+    if constexpr (op == Operation::IntrinsicAt) {
+      if (type == kTypeHandleArray || type == kTypeHandleString) {
+        Object &index = fetch(0);
+        if (frame.error) return;
+
+        if (index.GetTypeHandle() != kTypeHandleInt) {
+          frame.MakeError("Index must be an integer");
+          return;
+        }
+
+        auto value = index.Cast<int64_t>();
+        size_t size = type == kTypeHandleArray ? me.Cast<ObjectArray>().size() : me.Cast<string>().size();
+
+        if (value < 0 || size_t(value) >= size) {
+          frame.MakeError("Index is out of range");
+          return;
+        }
+
+        if (type == kTypeHandleArray) {
+          frame.RefreshReturnStack(ObjectView(&me.Cast<ObjectArray>()[size_t(value)]));
+        }
+        else {
+          frame.RefreshReturnStack(
+            Object(make_shared<string>(1, me.Cast<string>()[size_t(value)]), kTypeHandleString));
+        }
+        return;
+      }
+
+      if (type == kTypeHandleTable) {
+        Object &key = fetch(0);
+        if (frame.error) return;
+        frame.RefreshReturnStack(ObjectView(&me.Cast<ObjectTable>()[key]));
+        return;
+      }
+    }
+    else if constexpr (op == Operation::IntrinsicSize) {
+      int64_t size = -1;
+
+      switch (type) {
+      case kTypeHandleArray: size = static_cast<int64_t>(me.Cast<ObjectArray>().size()); break;
+      case kTypeHandleTable: size = static_cast<int64_t>(me.Cast<ObjectTable>().size()); break;
+      case kTypeHandleString: size = static_cast<int64_t>(me.Cast<string>().size()); break;
+      default: break;
+      }
+
+      if (size >= 0) {
+        frame.RefreshReturnStack(Object(size, kTypeHandleInt));
+        return;
+      }
+    }
+    else if constexpr (op == Operation::IntrinsicEmpty) {
+      if (type == kTypeHandleArray) {
+        frame.RefreshReturnStack(me.Cast<ObjectArray>().empty());
+        return;
+      }
+
+      if (type == kTypeHandleTable) {
+        frame.RefreshReturnStack(me.Cast<ObjectTable>().empty());
+        return;
+      }
+    }
+    else if constexpr (op == Operation::IntrinsicPush) {
+      if (type == kTypeHandleArray) {
+        Object &obj = fetch(0);
+        if (frame.error) return;
+        me.Cast<ObjectArray>().emplace_back(DumpObject(obj));
+        return;
+      }
+    }
+    else if constexpr (op == Operation::IntrinsicPop) {
+      if (type == kTypeHandleArray) {
+        auto &base = me.Cast<ObjectArray>();
+        if (!base.empty()) base.pop_back();
+        frame.RefreshReturnStack(base.empty());
+        return;
+      }
+    }
+    else if constexpr (op == Operation::IntrinsicFind) {
+      if (type == kTypeHandleTable) {
+        auto &table = me.Cast<ObjectTable>();
+        Object &key = fetch(0);
+        if (frame.error) return;
+
+        if (auto it = table.find(key); it != table.end()) {
+          frame.RefreshReturnStack(ObjectView(&it->second));
+        }
+        else {
+          frame.RefreshReturnStack(Object());
+        }
+        return;
+      }
+    }
+    else if constexpr (op == Operation::IntrinsicInsert) {
+      if (type == kTypeHandleTable) {
+        Object &value = fetch(1);
+        if (frame.error) return;
+        Object &key = fetch(0);
+        if (frame.error) return;
+
+        if (!IsPlainTypeHandle(key.GetTypeHandle())) {
+          frame.MakeError("Invalid key type");
+          return;
+        }
+
+        auto result = me.Cast<ObjectTable>().insert(make_pair(DumpObject(key), DumpObject(value)));
+        frame.RefreshReturnStack(result.second);
+        return;
+      }
+    }
+
+    IntrinsicFallback(inst, args);
+  }
+
+  // Same as calling in Run(). Script method is invoked like InvokeMethod(),
+  // its result is pushed by ResumeOperation().
+  void AASTMachine::IntrinsicFallback(Instruction &inst, ArgumentSpan &args) {
+    auto &frame = frame_stack_.top();
+    CommandPointer command = &inst;
+    FunctionPointer impl = nullptr;
+    ObjectMap obj_map;
+    CallArguments arg_list;
+
+    if (!FetchFunctionImpl(impl, command, obj_map)) return;
+
+    GenerateArgs2(*impl, args, arg_list);
+    if (frame.error) return;
+
+    if (impl->GetType() == FunctionType::UserDef) {
+      if (!CheckCallDepth()) return;
+
+      frame.void_call = false;
+      frame.suspended = true;
+      code_stack_.push_back(impl->GetCode());
+      frame_stack_.push();
+      obj_stack_.Push();
+      BindCallScope(*impl, obj_map, arg_list);
+      return;
+    }
+
+    if (impl->GetType() != FunctionType::Component) {
+      frame.MakeError("Internal Error(External function as method is not supported)");
+      return;
+    }
+
+    State state(frame, obj_stack_);
+    arg_list.ExportTo(impl->AccessParameters(), obj_map);
+
+    switch (impl->Get<Activity>()(state, obj_map)) {
+    case 1: frame.MakeWarning(state.GetMsg()); break;
+    case 2: frame.MakeError(state.GetMsg()); break;
+    default: break;
+    }
+
+    //value is pushed by component directly
+    if (state.HasValueReturned()) frame.cmd_value_returned = true;
+  }
+
+  void AASTMachine::ConditionBranch(Operation operation, bool state, size_t nest_end) {
+    auto &frame = frame_stack_.top();
+    auto &code = code_stack_.back();
+
+    if (operation == Operation::If || operation == Operation::While) {
+      frame.AddJumpRecord(nest_end);
+      code->FetchBranchTargets(frame.idx, frame.branch_jump_stack);
+    }
+
+    if (operation == Operation::If) {
+      auto create_env = [&]()->void {
+        frame.scope_indicator.push(true);
+        frame.condition_stack.push(state);
+        obj_stack_.Push(true, true);
+      };
+
+      if (!state) {
+        if (frame.branch_jump_stack.empty()) {
+          frame.Goto(frame.jump_stack.top());
+          frame.keep_condition = true;
+        }
+        else {
+          create_env();
+          frame.Goto(frame.branch_jump_stack.top());
+          frame.branch_jump_stack.pop();
+        }
+      }
+      else {
+        create_env();
+      }
+    }
+    else if (operation == Operation::Elif) {
       if (frame.condition_stack.empty()) {
         frame.MakeError("Unexpected Elif");
         return;
@@ -914,7 +1323,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::InitForEach(ArgumentList &args, size_t nest_end) {
+  void AASTMachine::InitForEach(ArgumentSpan &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
 
     auto container_obj = FetchObjectView(args[1]).Seek();
@@ -937,7 +1346,7 @@ namespace sapphire {
       frame.scope_indicator.push(true);
       obj_stack_.Push(true);
       obj_stack_.CreateObject(kStrContainerKeepAliveSlot, container_obj);
-      obj_stack_.CreateObject(kStrIteratorObj, Object(int64_t(0), kTypeIdInt));
+      obj_stack_.CreateObject(kStrIteratorObj, Object(int64_t(0), kTypeHandleInt));
 
       auto container_unit = container_obj.Cast<ObjectArray>().at(0);
       obj_stack_.CreateObject(unit_id, container_unit, TryAppendTokenId(unit_id));
@@ -962,7 +1371,7 @@ namespace sapphire {
       auto key_ref = it->first;
       auto key_copy = components::DumpObject(key_ref);
       auto container_unit = make_shared<ObjectPair>(key_copy, it->second);
-      obj_stack_.CreateObject(unit_id, Object(container_unit, kTypeIdPair), TryAppendTokenId(unit_id));
+      obj_stack_.CreateObject(unit_id, Object(container_unit, kTypeHandlePair), TryAppendTokenId(unit_id));
     }
     else {
       if (!CheckObjectBehavior(container_obj, "head|tail|empty")) {
@@ -970,48 +1379,14 @@ namespace sapphire {
         return;
       }
 
-      auto empty_result = CallMethod2(container_obj, kStrEmpty, {});
-      if (frame.error) return;
-      if (!(empty_result.has_value() && empty_result.value().GetTypeId() != kTypeIdBool)) {
-        frame.MakeError("Invalid type of return value from empty()");
-        return;
-      }
-
-      if (empty_result.value().Cast<bool>()) {
-        frame.Goto(nest_end);
-        frame.final_cycle = true;
-        obj_stack_.Push(true); //avoid error
-        frame.scope_indicator.push(false); //???
-      }
-
-      auto iterator_obj = CallMethod2(container_obj, kStrHead, {});
-      if (frame.error) return;
-      if (!iterator_obj.has_value()) {
-        frame.MakeError("Invalid type of return value from head()");
-        return;
-      }
-      if (!CheckObjectBehavior(iterator_obj.value(), "get|step|compare")) {
-        frame.MakeError("Head iterator doesn't have necessary - get & step &compare");
-        return;
-      }
-
-      auto container_unit = CallMethod2(iterator_obj.value(), "get", {});
-      if (frame.error) return;
-      if (!container_unit.has_value()) {
-        frame.MakeError("Invalid type of return value from get()");
-        return;
-      }
-
       frame.scope_indicator.push(true);
       obj_stack_.Push(true);
-      obj_stack_.CreateObject(kStrIteratorObj, iterator_obj.value());
       obj_stack_.CreateObject(kStrContainerKeepAliveSlot, container_obj);
-      obj_stack_.CreateObject(unit_id, container_unit.value(), TryAppendTokenId(unit_id));
-
+      IterateScriptContainer(IterationStage::None, std::nullopt);
     }
   }
 
-  void AASTMachine::CheckForEach(ArgumentList &args, size_t nest_end) {
+  void AASTMachine::CheckForEach(ArgumentSpan &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
     auto unit_id = FetchObjectView(args[0]).Seek().Cast<string>();
 
@@ -1046,51 +1421,144 @@ namespace sapphire {
         auto key_ref = it->first;
         auto key_copy = components::DumpObject(key_ref);
         auto unit = make_shared<ObjectPair>(key_copy, it->second);
-        obj_stack_.GetCurrent().Replace(unit_id, Object(unit, kTypeIdPair), TryAppendTokenId(unit_id));
+        obj_stack_.GetCurrent().Replace(unit_id, Object(unit, kTypeHandlePair), TryAppendTokenId(unit_id));
       }
     }
     else {
-      CallMethod2(*iterator_obj, "step", {});
-      if (frame.error) return;
+      IterateScriptContainer(IterationStage::None, std::nullopt);
+    }
+  }
 
-      auto tail_iterator = CallMethod2(*container_obj, kStrTail, {});
-      if (frame.error) return;
-      if (!tail_iterator.has_value()) {
-        frame.MakeError("Invalid type of return value from tail()");
-        return;
+  // Script container is enumerated through its methods:
+  //   first cycle:  empty() -> head() -> get()
+  //   other cycles: step() -> tail() -> compare() -> get()
+  // Every stage checks result of its method and invokes the next one, cycle
+  // is started with IterationStage::None. Script method suspends this command
+  // like InvokeMethod() does, ResumeOperation() comes back here with the
+  // stage saved in frame. Iterator and container are kept in loop scope.
+  void AASTMachine::IterateScriptContainer(IterationStage stage, optional<Object> result) {
+    auto &frame = frame_stack_.top();
+    auto &code = *code_stack_.back();
+    auto &inst = code[frame.idx];
+    auto args = code.GetArguments(inst);
+    auto nest_end = inst.annotation.nest_end;
+
+    auto find = [&](const string &id) -> Object & {
+      return *obj_stack_.GetCurrent().Find(id, false);
+    };
+
+    //returns true if method is finished in place
+    auto invoke = [&](Object &obj, const string &id, ObjectMap &&method_args, IterationStage next) -> bool {
+      stage = next;
+      frame.iteration_stage = next;
+      result = InvokeMethod(obj, id, method_args);
+      return !frame.suspended && !frame.error;
+    };
+
+    auto finish_loop = [&]() -> void {
+      frame.Goto(nest_end);
+      frame.final_cycle = true;
+    };
+
+    auto is_bool = [&]() -> bool {
+      return result.has_value() && result.value().GetTypeHandle() == kTypeHandleBool;
+    };
+
+    if (stage == IterationStage::None) {
+      auto *iterator_obj = obj_stack_.GetCurrent().Find(kStrIteratorObj, false);
+
+      if (iterator_obj != nullptr) {
+        if (!invoke(*iterator_obj, "step", {}, IterationStage::Step)) return;
       }
-      if (!CheckObjectBehavior(tail_iterator.value(), "get|step|compare")) {
-        frame.MakeError("Tail iterator doesn't have necessary methods");
+      else if (!invoke(find(kStrContainerKeepAliveSlot), kStrEmpty, {}, IterationStage::Empty)) {
         return;
       }
+    }
 
-      auto comp_result = CallMethod2(*iterator_obj, "compare",
-        { NamedObject(kStrRightHandSide, tail_iterator.value()) });
-      if (frame.error) return;
-      if (!(comp_result.has_value() && comp_result.value().GetTypeId() != kTypeIdBool)) {
-        frame.MakeError("Invalid type of return value from compare()");
-        return;
-      }
+    while (!frame.error) {
+      switch (stage) {
+      case IterationStage::Empty:
+        if (!is_bool()) {
+          frame.MakeError("Invalid type of return value from empty()");
+          break;
+        }
 
-      if (comp_result.value().Cast<bool>()) {
-        frame.Goto(nest_end);
-        frame.final_cycle = true;
-      }
-      else {
-        auto unit = CallMethod2(*iterator_obj, "get", {});
-        if (frame.error) return;
-        if (!unit.has_value()) {
-          frame.MakeError("Invaild type of return value from get()");
-          return;
+        if (result.value().Cast<bool>()) {
+          finish_loop();
+          break;
+        }
+
+        if (!invoke(find(kStrContainerKeepAliveSlot), kStrHead, {}, IterationStage::Head)) return;
+        continue;
+      case IterationStage::Head:
+        if (!result.has_value()) {
+          frame.MakeError("Invalid type of return value from head()");
+          break;
+        }
+
+        if (!CheckObjectBehavior(result.value(), "get|step|compare")) {
+          frame.MakeError("Head iterator doesn't have necessary - get & step &compare");
+          break;
+        }
+
+        obj_stack_.CreateObject(kStrIteratorObj, result.value());
+        if (!invoke(find(kStrIteratorObj), "get", {}, IterationStage::Get)) return;
+        continue;
+      case IterationStage::Step:
+        if (!invoke(find(kStrContainerKeepAliveSlot), kStrTail, {}, IterationStage::Tail)) return;
+        continue;
+      case IterationStage::Tail:
+        if (!result.has_value()) {
+          frame.MakeError("Invalid type of return value from tail()");
+          break;
+        }
+
+        if (!CheckObjectBehavior(result.value(), "get|step|compare")) {
+          frame.MakeError("Tail iterator doesn't have necessary methods");
+          break;
+        }
+
+        if (!invoke(find(kStrIteratorObj), "compare",
+          { NamedObject(kStrRightHandSide, result.value()) }, IterationStage::Compare)) return;
+        continue;
+      case IterationStage::Compare:
+        if (!is_bool()) {
+          frame.MakeError("Invalid type of return value from compare()");
+          break;
+        }
+
+        if (result.value().Cast<bool>()) {
+          finish_loop();
+          break;
+        }
+
+        if (!invoke(find(kStrIteratorObj), "get", {}, IterationStage::Get)) return;
+        continue;
+      case IterationStage::Get: {
+        if (!result.has_value()) {
+          frame.MakeError("Invalid type of return value from get()");
+          break;
         }
-        obj_stack_.GetCurrent().Replace(unit_id, unit.value(), TryAppendTokenId(unit_id));
+
+        auto unit_id = FetchObjectView(args[0]).Seek().Cast<string>();
+        if (frame.error) break;
+        obj_stack_.GetCurrent().Replace(unit_id, result.value(), TryAppendTokenId(unit_id));
+        break;
+      }
+      default:
+        break;
       }
+
+      break;
     }
+
+    frame.iteration_stage = IterationStage::None;
   }
 
-  void AASTMachine::CommandCase(ArgumentList &args, size_t nest_end) {
+  void AASTMachine::CommandCase(Instruction &inst, ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     auto &code = code_stack_.back();
+    auto nest_end = inst.annotation.nest_end;
 
     if (args.empty()) {
       frame.MakeError("Empty argument list");
@@ -1099,19 +1567,29 @@ namespace sapphire {
 
     frame.AddJumpRecord(nest_end);
 
-    bool has_jump_list = 
-      code->FindJumpRecord(frame.idx + frame.jump_offset, frame.branch_jump_stack);
-
     auto view = FetchObjectView(args[0]);
     if (frame.error) return;
 
-    string type_id = view.Seek().GetTypeId();
-
-    if (!lexical::IsPlainType(type_id)) {
+    if (!IsPlainTypeHandle(view.Seek().GetTypeHandle())) {
       frame.MakeError("Non-plain object is not supported for now");
       return;
     }
 
+    //matching clause is found at once, its body is entered directly
+    if (inst.case_table != kNoCaseTable) {
+      size_t target = code->GetCaseTable(inst).Find(view.Seek());
+
+      frame.scope_indicator.push(true);
+      obj_stack_.Push(true);
+      obj_stack_.CreateObject(kStrCaseObj, view.Seek());
+      frame.condition_stack.push(target != nest_end);
+      frame.Goto(target != nest_end ? target + 1 : target);
+      return;
+    }
+
+    bool has_jump_list = 
+      code->FetchBranchTargets(frame.idx, frame.branch_jump_stack);
+
     frame.scope_indicator.push(true);
     obj_stack_.Push(true);
     obj_stack_.CreateObject(kStrCaseObj, view.Seek());
@@ -1143,7 +1621,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandWhen(ArgumentList &args) {
+  void AASTMachine::CommandWhen(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     bool result = false;
 
@@ -1159,7 +1637,6 @@ namespace sapphire {
 
     if (!args.empty()) {
       ObjectPointer ptr = obj_stack_.Find(kStrCaseObj);
-      string type_id = ptr->GetTypeId();
       bool found = false;
 
       if (ptr == nullptr) {
@@ -1167,7 +1644,9 @@ namespace sapphire {
         return;
       }
 
-      if (!lexical::IsPlainType(type_id)) {
+      auto type = ptr->GetTypeHandle();
+
+      if (!IsPlainTypeHandle(type)) {
         frame.MakeError("Non-plain object is not supported");
         return;
       }
@@ -1178,19 +1657,14 @@ namespace sapphire {
         auto obj = FetchObjectView(*it);
         if (frame.error) return;
 
-        if (obj.Seek().GetTypeId() != type_id) continue;
+        if (obj.Seek().GetTypeHandle() != type) continue;
 
-        if (type_id == kTypeIdInt) {
-          found = COMPARE_RESULT(int64_t);
-        }
-        else if (type_id == kTypeIdFloat) {
-          found = COMPARE_RESULT(double);
-        }
-        else if (type_id == kTypeIdString) {
-          found = COMPARE_RESULT(string);
-        }
-        else if (type_id == kTypeIdBool) {
-          found = COMPARE_RESULT(bool);
+        switch (type) {
+        case kTypeHandleInt: found = COMPARE_RESULT(int64_t); break;
+        case kTypeHandleFloat: found = COMPARE_RESULT(double); break;
+        case kTypeHandleString: found = COMPARE_RESULT(string); break;
+        case kTypeHandleBool: found = COMPARE_RESULT(bool); break;
+        default: break;
         }
 
         if (found) break;
@@ -1241,7 +1715,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandStructBegin(ArgumentList &args) {
+  void AASTMachine::CommandStructBegin(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (args.size() < 1) {
@@ -1261,19 +1735,19 @@ namespace sapphire {
 
     if (frame.error) return;
 
-    frame.struct_id = id_obj.Cast<string>();
+    frame.Detail().struct_id = id_obj.Cast<string>();
 
     if (!super_struct_obj.NullPtr()) {
-      frame.super_struct_id = super_struct_obj.Cast<string>();
+      frame.Detail().super_struct_id = super_struct_obj.Cast<string>();
     }
 
-    //NOTICE: frame.struct_id = id_obj.Cast<string>();
-    if (auto *ptr = obj_stack_.Find(frame.struct_id, args[0].properties.token_id); ptr != nullptr) {
-      frame.MakeError("Struct is existed: " + frame.struct_id);
+    //NOTICE: frame.Detail().struct_id = id_obj.Cast<string>();
+    if (auto *ptr = obj_stack_.Find(frame.Detail().struct_id, args[0].properties.token_id); ptr != nullptr) {
+      frame.MakeError("Struct is existed: " + frame.Detail().struct_id);
     }
   }
 
-  void AASTMachine::CommandModuleBegin(ArgumentList &args) {
+  void AASTMachine::CommandModuleBegin(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(1)) {
@@ -1284,7 +1758,7 @@ namespace sapphire {
     obj_stack_.Push(true);
     auto id_obj = FetchObjectView(args[0]).Seek();
     //Use struct_id slot
-    frame.struct_id = id_obj.Cast<string>();
+    frame.Detail().struct_id = id_obj.Cast<string>();
   }
 
   void AASTMachine::CommandConditionEnd() {
@@ -1313,10 +1787,7 @@ namespace sapphire {
       }
       else {
         if (frame.from_break) frame.from_break = false;
-        while (!frame.return_stack.empty()) {
-          delete frame.return_stack.back();
-          frame.return_stack.pop_back();
-        }
+        frame.return_stack.Clear();
         frame.jump_stack.pop();
         obj_stack_.Pop();
         
@@ -1326,10 +1797,7 @@ namespace sapphire {
     }
     else {
       frame.Goto(nest);
-      while (!frame.return_stack.empty()) {
-        delete frame.return_stack.back();
-        frame.return_stack.pop_back();
-      }
+      frame.return_stack.Clear();
       obj_stack_.ClearCurrent();
       //obj_stack_.GetCurrent().Clear();
       frame.jump_from_end = true;
@@ -1370,8 +1838,8 @@ namespace sapphire {
     Object *super_struct = nullptr;
 
     //inheritance implementation
-    if (!frame.super_struct_id.empty()) {
-      super_struct = obj_stack_.Find(frame.super_struct_id);
+    if (!frame.Detail().super_struct_id.empty()) {
+      super_struct = obj_stack_.Find(frame.Detail().super_struct_id);
       if (super_struct == nullptr) {
         frame.MakeError("Invalid super struct");
         return;
@@ -1382,15 +1850,15 @@ namespace sapphire {
     if (super_struct != nullptr) {
       auto &super_base = super_struct->Cast<ObjectStruct>();
 
-      for (auto &unit : super_base.GetContent()) {
-        if (compare(unit.first, kStrSuperStruct, kStrStructId)) continue;
-        if (unit.second.GetTypeId() != kTypeIdFunction) {
-          managed_struct->Add(unit.first, components::DumpObject(unit.second));
+      super_base.ForEach([&](const string &id, Object &obj) {
+        if (compare(id, kStrSuperStruct, kStrStructId)) return;
+        if (obj.GetTypeHandle() != kTypeHandleFunction) {
+          managed_struct->Add(id, components::DumpObject(obj));
         }
         else {
-          managed_struct->Add(unit.first, unit.second);
+          managed_struct->Add(id, obj);
         }
-      }
+      });
 
       //create reference obejct of super struct
       managed_struct->Add(kStrSuperStruct, Object().PackObject(*super_struct));
@@ -1407,7 +1875,7 @@ namespace sapphire {
           //simple patch
           if (unit.first == kStrInitializer) continue;
 
-          if (unit.second.GetTypeId() != kTypeIdFunction) {
+          if (unit.second.GetTypeHandle() != kTypeHandleFunction) {
             managed_struct->Add(unit.first, components::DumpObject(unit.second));
           }
           else {
@@ -1421,17 +1889,31 @@ namespace sapphire {
       managed_struct->Replace(unit.first, unit.second);
     }
 
-    managed_struct->Add(kStrStructId, Object(frame.struct_id));
+    managed_struct->Add(kStrStructId, Object(frame.Detail().struct_id));
+
+    //members of instance are laid out by shape of struct, methods are
+    //moved to method table of shape instead of being copied to instances
+    auto shape = make_shared<StructShape>();
+    for (auto &unit : managed_struct->GetContent()) {
+      if (compare(unit.first, kStrInitializer, kStrStructId, kStrSuperStruct)) continue;
+      if (unit.second.GetTypeHandle() == kTypeHandleFunction) {
+        shape->AppendMethod(unit.first, unit.second);
+      }
+      else {
+        shape->Append(unit.first);
+      }
+    }
+    managed_struct->ApplyShape(shape);
 
     obj_stack_.Pop();
     
     obj_stack_.CreateObject(
-      frame.struct_id, 
-      Object(managed_struct, kTypeIdStruct),
-      TryAppendTokenId(frame.struct_id)
+      frame.Detail().struct_id, 
+      Object(managed_struct, kTypeHandleStruct),
+      TryAppendTokenId(frame.Detail().struct_id)
     );
-    frame.struct_id.clear();
-    frame.struct_id.shrink_to_fit();
+    frame.Detail().struct_id.clear();
+    frame.Detail().struct_id.shrink_to_fit();
   }
 
   void AASTMachine::CommandModuleEnd() {
@@ -1443,20 +1925,20 @@ namespace sapphire {
       managed_module->Add(unit.first, unit.second);
     }
 
-    managed_module->Add(kStrStructId, Object(frame.struct_id));
+    managed_module->Add(kStrStructId, Object(frame.Detail().struct_id));
 
     obj_stack_.Pop();
     
     obj_stack_.CreateObject(
-      frame.struct_id, 
-      Object(managed_module, kTypeIdStruct),
-      TryAppendTokenId(frame.struct_id)
+      frame.Detail().struct_id, 
+      Object(managed_module, kTypeHandleStruct),
+      TryAppendTokenId(frame.Detail().struct_id)
     );
-    frame.struct_id.clear();
-    frame.struct_id.shrink_to_fit();
+    frame.Detail().struct_id.clear();
+    frame.Detail().struct_id.shrink_to_fit();
   }
 
-  void AASTMachine::CommandInclude(ArgumentList &args) {
+  void AASTMachine::CommandInclude(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     auto &base = obj_stack_.GetCurrent();
     auto module_view = FetchObjectView(args[0]);
@@ -1476,13 +1958,13 @@ namespace sapphire {
     }
     else {
       auto managed_arr = make_shared<ObjectArray>();
-      base.Add(kStrModuleList, Object(managed_arr, kTypeIdArray));
+      base.Add(kStrModuleList, Object(managed_arr, kTypeHandleArray));
       auto &mod_list = base.Find(kStrModuleList)->Cast<ObjectArray>();
       mod_list.push_back(module_obj);
     }
   }
 
-  void AASTMachine::CommandSuper(ArgumentList &args) {
+  void AASTMachine::CommandSuper(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     auto &base = obj_stack_.GetCurrent();
 
@@ -1513,7 +1995,7 @@ namespace sapphire {
         return;
       }
 
-      if (initializer->GetTypeId() != kTypeIdFunction) {
+      if (initializer->GetTypeHandle() != kTypeHandleFunction) {
         frame.MakeError("Invalid initializer function");
         return;
       }
@@ -1545,7 +2027,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandAttribute(ArgumentList &args) {
+  void AASTMachine::CommandAttribute(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     bool error = false;
 
@@ -1568,7 +2050,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandSwap(ArgumentList &args) {
+  void AASTMachine::CommandSwap(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (args.size() == 2) {
@@ -1591,7 +2073,7 @@ namespace sapphire {
 
       if (frame.error) return;
 
-      if (!compare(right.GetTypeId(), left.GetTypeId(), kTypeIdInt)) {
+      if (!compare(right.GetTypeHandle(), left.GetTypeHandle(), kTypeHandleInt)) {
         frame.MakeError("Invalid index");
         return;
       }
@@ -1630,7 +2112,7 @@ namespace sapphire {
 
   }
 
-  void AASTMachine::CommandBind(ArgumentList &args, bool local_value, bool ext_value) {
+  void AASTMachine::CommandBind(ArgumentSpan &args, bool local_value, bool ext_value) {
     auto &frame = frame_stack_.top();
 
     if (args[0].GetType() == ArgumentType::Literal &&
@@ -1647,7 +2129,9 @@ namespace sapphire {
 
     if (lhs.source == ObjectViewSource::Ref) {
       auto &real_lhs = lhs.Seek().Unpack();
-      real_lhs = components::DumpObject(rhs.Seek());
+      //unboxed struct member is overwritten in place
+      if (real_lhs.IsUnboxed()) components::DumpObject(rhs, ObjectView(&real_lhs));
+      else real_lhs = components::DumpObject(rhs.Seek());
       return;
     }
     else {
@@ -1658,9 +2142,9 @@ namespace sapphire {
         return;
       }
 
-      if (!local_value && frame.struct_id.empty()) {
+      if (!local_value && !frame.InsideStructDefinition()) {
         // pending modification
-        ObjectPointer ptr = obj_stack_.Find(id);
+        ObjectPointer ptr = FindNamedObject(args[0], true);
 
         if (ptr != nullptr) {
           if (!ptr->IsAlive()) {
@@ -1673,14 +2157,34 @@ namespace sapphire {
         }
       }
 
-      if (!obj_stack_.CreateObject(id, components::DumpObject(rhs.Seek()), args[0].properties.token_id)) {
+      auto *ptr = obj_stack_.CreateObject(id, components::DumpObject(rhs.Seek()), args[0].properties.token_id);
+
+      if (ptr == nullptr) {
         frame.MakeError("Object binding is failed");
         return;
       }
+
+      FillLocalSlots(args[0], ptr);
     }
   }
 
-  void AASTMachine::CommandDelivering(ArgumentList &args, bool local_value, bool ext_value) {
+  // New object in current scope is stored into slots of its identifier,
+  // so it's read by index from the very first time.
+  void AASTMachine::FillLocalSlots(Operand &target, ObjectPointer ptr) {
+    auto token_id = target.properties.token_id;
+    if (target.slot == kNoSlot || token_id == 0) return;
+
+    auto &frame = frame_stack_.top();
+    auto &code = *code_stack_.back();
+    auto group = code.FindLinkedSlots(target.slot);
+    auto version = GetBindingVersion(token_id);
+    auto scope = obj_stack_.GetScopeSerial();
+
+    if (group.named != kNoSlot) frame.GetSlot(code, group.named).Fill(ptr, version, scope);
+    if (group.domain != kNoSlot) frame.GetSlot(code, group.domain).Fill(ptr, version, scope);
+  }
+
+  void AASTMachine::CommandDelivering(ArgumentSpan &args, bool local_value, bool ext_value) {
     auto &frame = frame_stack_.top();
 
     if (args[0].GetType() == ArgumentType::Literal &&
@@ -1713,8 +2217,8 @@ namespace sapphire {
         return;
       }
 
-      if (!local_value && frame.struct_id.empty()) {
-        ObjectPointer ptr = obj_stack_.Find(id);
+      if (!local_value && !frame.InsideStructDefinition()) {
+        ObjectPointer ptr = FindNamedObject(args[0], true);
 
         if (ptr != nullptr) {
           if (!ptr->IsAlive()) {
@@ -1730,14 +2234,18 @@ namespace sapphire {
 
       rhs.Seek().Unpack() = Object();
 
-      if (!obj_stack_.CreateObject(id, rhs.Seek().Unpack(), args[0].properties.token_id)) {
+      auto *ptr = obj_stack_.CreateObject(id, rhs.Seek().Unpack(), args[0].properties.token_id);
+
+      if (ptr == nullptr) {
         frame.MakeError("Object delivering is failed");
         return;
       }
+
+      FillLocalSlots(args[0], ptr);
     }
   }
 
-  void AASTMachine::CommandTypeId(ArgumentList &args) {
+  void AASTMachine::CommandTypeId(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (args.size() > 1) {
@@ -1759,7 +2267,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandUsing(ArgumentList &args) {
+  void AASTMachine::CommandUsing(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(1)) {
@@ -1770,7 +2278,7 @@ namespace sapphire {
     auto &path_obj = FetchObjectView(args[0]).Seek();
     if (frame.error) return;
 
-    if (path_obj.GetTypeId() != kTypeIdString) {
+    if (path_obj.GetTypeHandle() != kTypeHandleString) {
       frame.MakeError("Invalid path");
       return;
     }
@@ -1800,9 +2308,12 @@ namespace sapphire {
       GrammarAndSemanticAnalysis factory(absolute_path, script_file, logger_);
 
       if (factory.Start()) {
-        AASTMachine sub_machine(script_file, logger_);
+        ASTOptimizer(script_file, runtime::GetOptimizationLevel()).Start();
+        Bytecode bytecode(script_file);
+        AASTMachine sub_machine(bytecode, logger_);
         auto &obj_base = obj_stack_.GetBase();
         sub_machine.SetDelegatedRoot(obj_base.front());
+        sub_machine.SetParentMachine(*this);
         sub_machine.Run();
 
         if (sub_machine.ErrorOccurred()) {
@@ -1818,7 +2329,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandPrint(ArgumentList &args) {
+  void AASTMachine::PrintObject(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (args.size() != 1) {
@@ -1829,11 +2340,11 @@ namespace sapphire {
     auto view = FetchObjectView(args[0]);
     if (frame.error) return;
 
-    auto type_id = view.Seek().GetTypeId();
+    auto type = view.Seek().GetTypeHandle();
     auto &obj = view.Seek();
 
-    if (lexical::IsPlainType(type_id)) {
-      if (type_id == kTypeIdInt) {
+    if (IsPlainTypeHandle(type)) {
+      if (type == kTypeHandleInt) {
 //#ifndef _MSC_VER
 //        fprintf(VM_STDOUT, "%ld", obj.Cast<int64_t>());
 //#else
@@ -1849,13 +2360,13 @@ namespace sapphire {
 #endif
 #endif
       }
-      else if (type_id == kTypeIdFloat) {
+      else if (type == kTypeHandleFloat) {
         fprintf(VM_STDOUT, "%f", obj.Cast<double>());
       }
-      else if (type_id == kTypeIdString) {
+      else if (type == kTypeHandleString) {
         fputs(obj.Cast<string>().data(), VM_STDOUT);
       }
-      else if (type_id == kTypeIdBool) {
+      else if (type == kTypeHandleBool) {
         fputs(obj.Cast<bool>() ? "true" : "false", VM_STDOUT);
       }
     }
@@ -1866,12 +2377,20 @@ namespace sapphire {
         fputs(msg.data(), VM_STDOUT);
       }
       else {
-        CallMethod2(obj, kStrPrint, {});
+        InvokeMethod(obj, kStrPrint, {});
       }
     }
   }
 
-  void AASTMachine::CommandSleep(ArgumentList &args) {
+  void AASTMachine::CommandPrint(ArgumentSpan &args, bool new_line) {
+    auto &frame = frame_stack_.top();
+
+    PrintObject(args);
+    //line break of suspended printing is left to ResumeOperation()
+    if (new_line && !frame.suspended) fputs("\n", VM_STDOUT);
+  }
+
+  void AASTMachine::CommandSleep(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (args.size() != 1) {
@@ -1881,7 +2400,7 @@ namespace sapphire {
 
     auto view = FetchObjectView(args[0]);
     if (frame.error) return;
-    if (view.Seek().GetTypeId() != kTypeIdInt) {
+    if (view.Seek().GetTypeHandle() != kTypeHandleInt) {
       frame.MakeError("Invalid sleep duration");
       return;
     }
@@ -1907,57 +2426,99 @@ namespace sapphire {
 #endif
   }
 
+  // Specialized kernels of quickened operators.
+  // Both operands are guaranteed to be plain objects of given type.
   template <Operation op_code>
-  void AASTMachine::BinaryMathOperatorImpl(ArgumentList &args) {
+  void AASTMachine::QuickMathOperator(TypeHandle type, Object &lhs, Object &rhs) {
     auto &frame = frame_stack_.top();
 
-    if (!EXPECTED_COUNT(2)) {
-      frame.MakeError("Argument behind operator is missing");
-      return;
-    }
-
-    auto rhs = FetchObjectView(args[1]);
-    auto lhs = FetchObjectView(args[0]);
-    if (frame.error) return;
+#define QUICK_PROCESSING(_Type, _TypeId)                                            \
+  frame.RefreshReturnStack(                                                       \
+    Object(MathBox<_Type, op_code>().Do(lhs.Cast<_Type>(), rhs.Cast<_Type>()), _TypeId));
 
-    auto type_rhs = FindTypeCode(rhs.Seek().GetTypeId());
-    auto type_lhs = FindTypeCode(lhs.Seek().GetTypeId());
-
-    if (frame.error) return;
+    switch (type) {
+    case kTypeHandleInt: QUICK_PROCESSING(int64_t, kTypeHandleInt); break;
+    case kTypeHandleFloat: QUICK_PROCESSING(double, kTypeHandleFloat); break;
+    case kTypeHandleBool: QUICK_PROCESSING(bool, kTypeHandleBool); break;
+    case kTypeHandleString:
+      if (IsIllegalStringOperator(op_code)) {
+        frame.RefreshReturnStack(Object());
+        break;
+      }
 
-    if (type_lhs == PlainType::Invalid || type_rhs  == PlainType::Invalid) {
-      frame.MakeError("Try to operate with non-plain type.");
+      QUICK_PROCESSING(string, kTypeHandleString);
+      break;
+    default:
+      break;
+    }
+#undef QUICK_PROCESSING
+  }
+
+  //returns false if operator is disposed for this type
+  template <Operation op_code>
+  bool AASTMachine::QuickLogicOperator(TypeHandle type, Object &lhs, Object &rhs, bool &result) {
+#define QUICK_PROCESSING(_Type) \
+  result = LogicBox<_Type, op_code>().Do(lhs.Cast<_Type>(), rhs.Cast<_Type>());
+
+    switch (type) {
+    case kTypeHandleInt: QUICK_PROCESSING(int64_t); break;
+    case kTypeHandleFloat: QUICK_PROCESSING(double); break;
+    case kTypeHandleBool: QUICK_PROCESSING(bool); break;
+    case kTypeHandleString:
+      if (IsIllegalStringOperator(op_code)) return false;
+      QUICK_PROCESSING(string);
+      break;
+    default:
+      break;
+    }
+#undef QUICK_PROCESSING
+
+    return true;
+  }
+
+  template <Operation op_code>
+  void AASTMachine::BinaryMathOperatorImpl(Instruction &inst, ArgumentSpan &args) {
+    auto &frame = frame_stack_.top();
+
+    if (!EXPECTED_COUNT(2)) {
+      frame.MakeError("Argument behind operator is missing");
       return;
     }
 
-    auto result_type = kResultDynamicTraits.at(ResultTraitKey(type_lhs, type_rhs));
+    auto rhs = FetchObjectView(args[1]);
+    auto lhs = FetchObjectView(args[0]);
+    if (frame.error) return;
 
-#define RESULT_PROCESSING(_Type, _Func, _TypeId)                                     \
-  _Type result = MathBox<_Type, op_code>().Do(_Func(lhs.Seek()), _Func(rhs.Seek())); \
-  frame.RefreshReturnStack(Object(result, _TypeId));
+    auto handle_rhs = rhs.Seek().GetTypeHandle();
+    auto handle_lhs = lhs.Seek().GetTypeHandle();
 
-    if (result_type == PlainType::String) {
-      if (IsIllegalStringOperator(op_code)) {
-        frame.RefreshReturnStack(Object());
+    if (inst.IsQuickened()) {
+      if (handle_lhs == inst.quickened && handle_rhs == inst.quickened) {
+        QuickMathOperator<op_code>(inst.quickened, lhs.Seek(), rhs.Seek());
         return;
       }
 
-      RESULT_PROCESSING(string, StringProducer, kTypeIdString);
+      inst.Dequicken();
     }
-    else if (result_type == PlainType::Int) {
-      RESULT_PROCESSING(int64_t, IntProducer, kTypeIdInt);
+    else if (handle_lhs == handle_rhs && IsPlainTypeHandle(handle_lhs)) {
+      inst.Quicken(handle_lhs);
     }
-    else if (result_type == PlainType::Float) {
-      RESULT_PROCESSING(double, FloatProducer, kTypeIdFloat);
-    }
-    else if (result_type == PlainType::Bool) {
-      RESULT_PROCESSING(bool, BoolProducer, kTypeIdBool);
+
+    auto type_rhs = FindTypeCode(rhs.Seek().GetTypeHandle());
+    auto type_lhs = FindTypeCode(lhs.Seek().GetTypeHandle());
+
+    if (frame.error) return;
+
+    if (type_lhs == PlainType::Invalid || type_rhs  == PlainType::Invalid) {
+      frame.MakeError("Try to operate with non-plain type.");
+      return;
     }
-#undef RESULT_PROCESSING
+
+    frame.RefreshReturnStack(PlainMathOperation<op_code>(lhs.Seek(), rhs.Seek()));
   }
 
   template <Operation op_code>
-  void AASTMachine::BinaryLogicOperatorImpl(ArgumentList &args) {
+  void AASTMachine::BinaryLogicOperatorImpl(Instruction &inst, ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(2)) {
@@ -1969,13 +2530,78 @@ namespace sapphire {
     auto lhs = FetchObjectView(args[0]);
     if (frame.error) return;
 
-    auto type_rhs = FindTypeCode(rhs.Seek().GetTypeId());
-    auto type_lhs = FindTypeCode(lhs.Seek().GetTypeId());
-    bool result = false;
+    BinaryLogicOperation<op_code>(inst, lhs, rhs);
+  }
 
-    if (frame.error) return;
+  // Comparison part of CompareBranch.
+  // Generic path still produces an object, it is taken back from return
+  // stack right away.
+  template <Operation op_code>
+  bool AASTMachine::CompareOperands(Instruction &inst, ArgumentSpan &args, bool &state) {
+    auto &frame = frame_stack_.top();
+
+    auto rhs = FetchObjectView(args[1]);
+    auto lhs = FetchObjectView(args[0]);
+    if (frame.error) return false;
+
+    if (inst.IsQuickened() && lhs.Seek().GetTypeHandle() == inst.quickened &&
+      rhs.Seek().GetTypeHandle() == inst.quickened) {
+      if (!QuickLogicOperator<op_code>(inst.quickened, lhs.Seek(), rhs.Seek(), state)) {
+        frame.MakeError("Invalid state value type.");
+        return false;
+      }
+
+      return true;
+    }
+
+    auto void_call = frame.void_call;
+    frame.void_call = false;
+    BinaryLogicOperation<op_code>(inst, lhs, rhs);
+    //branching is done by ResumeOperation()
+    if (frame.suspended) return false;
+    frame.void_call = void_call;
+    frame.cmd_value_returned = false;
+    if (frame.error) return false;
+
+    auto &top = frame.return_stack.back();
+
+    if (!top.IsAlive() || top.Seek().GetTypeHandle() != kTypeHandleBool) {
+      frame.MakeError("Invalid state value type.");
+      return false;
+    }
+
+    state = top.Seek().Cast<bool>();
+    frame.return_stack.pop_back();
+    return true;
+  }
+
+  template <Operation op_code>
+  void AASTMachine::BinaryLogicOperation(Instruction &inst, ObjectView &lhs, ObjectView &rhs) {
+    auto &frame = frame_stack_.top();
+    auto handle_rhs = rhs.Seek().GetTypeHandle();
+    auto handle_lhs = lhs.Seek().GetTypeHandle();
+
+    if (inst.IsQuickened()) {
+      if (handle_lhs == inst.quickened && handle_rhs == inst.quickened) {
+        bool result = false;
+
+        if (QuickLogicOperator<op_code>(inst.quickened, lhs.Seek(), rhs.Seek(), result)) {
+          frame.RefreshReturnStack(result);
+        }
+        else {
+          frame.RefreshReturnStack(Object());
+        }
 
-    if (!lexical::IsPlainType(lhs.Seek().GetTypeId())) {
+        return;
+      }
+
+      inst.Dequicken();
+    }
+    else if (handle_lhs == handle_rhs && IsPlainTypeHandle(handle_lhs)) {
+      inst.Quicken(handle_lhs);
+    }
+
+    if (!IsPlainTypeHandle(handle_lhs)) {
       if constexpr (op_code != Operation::Equals && op_code != Operation::NotEqual) {
         frame.RefreshReturnStack(Object());
       }
@@ -1985,51 +2611,26 @@ namespace sapphire {
           return;
         }
 
-        auto result = CallMethod2(lhs.Seek(), kStrCompare, { NamedObject(kStrRightHandSide, rhs.Dump()) });
-        if (frame.error) return;
-        Object obj = result.has_value() ? result.value() : Object();
+        bool value = false;
+        auto result = InvokeMethod(lhs.Seek(), kStrCompare, { NamedObject(kStrRightHandSide, rhs.Dump()) });
+        if (frame.error || frame.suspended) return;
+        if (!FetchCompareResult(result, op_code, value)) return;
 
-        if (obj.GetTypeId() != kTypeIdBool) {
-          frame.MakeError("Invalid behavior of compare()");
-          return;
-        }
-
-        bool value = obj.Cast<bool>();
-
-        frame.RefreshReturnStack(op_code == Operation::NotEqual ? !value : value);
+        frame.RefreshReturnStack(value);
       }
 
       return;
     }
 
-    auto result_type = kResultDynamicTraits.at(ResultTraitKey(type_lhs, type_rhs));
-#define RESULT_PROCESSING(_Type, _Func) \
-  result = LogicBox<_Type, op_code>().Do(_Func(lhs.Seek()), _Func(rhs.Seek()));
-
-    if (result_type == PlainType::String) {
-      if (IsIllegalStringOperator(op_code)) {
-        frame.RefreshReturnStack(Object());
-        return;
-      }
-
-      RESULT_PROCESSING(string, StringProducer);
-    }
-    else if (result_type == PlainType::Int) {
-      RESULT_PROCESSING(int64_t, IntProducer);
-    }
-    else if (result_type == PlainType::Float) {
-      RESULT_PROCESSING(double, FloatProducer);
-    }
-    else if (result_type == PlainType::Bool) {
-      RESULT_PROCESSING(bool, BoolProducer);
+    if (!IsPlainTypeHandle(handle_rhs)) {
+      frame.MakeError("Try to operate with non-plain type.");
+      return;
     }
 
-
-    frame.RefreshReturnStack(result);
-#undef RESULT_PROCESSING
+    frame.RefreshReturnStack(PlainLogicOperation<op_code>(lhs.Seek(), rhs.Seek()));
   }
 
-  void AASTMachine::OperatorLogicNot(ArgumentList &args) {
+  void AASTMachine::OperatorLogicNot(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(1)) {
@@ -2041,7 +2642,7 @@ namespace sapphire {
     auto &rhs = FetchObjectView(args[0]).Seek();
     if (frame.error) return;
 
-    if (rhs.GetTypeId() != kTypeIdBool) {
+    if (rhs.GetTypeHandle() != kTypeHandleBool) {
       frame.MakeError("Can't operate with this operator");
       return;
     }
@@ -2052,7 +2653,7 @@ namespace sapphire {
     frame.RefreshReturnStack(result);
   }
 
-  void AASTMachine::OperatorIncreasing(ArgumentList &args) {
+  void AASTMachine::OperatorIncreasing(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(2)) {
@@ -2065,7 +2666,7 @@ namespace sapphire {
 
     if (frame.error) return;
 
-    if (!compare(lhs.Seek().GetTypeId(), rhs.Seek().GetTypeId(), kTypeIdInt)) {
+    if (!compare(lhs.Seek().GetTypeHandle(), rhs.Seek().GetTypeHandle(), kTypeHandleInt)) {
       frame.MakeError("Unsupported type");
       return;
     }
@@ -2074,7 +2675,22 @@ namespace sapphire {
     value += rhs.Seek().Cast<int64_t>();
   }
 
-  void AASTMachine::OperatorDecreasing(ArgumentList &args) {
+  // Fused '+=' and '-=' with integer literal
+  void AASTMachine::OperatorIncreaseBy(Instruction &inst, ArgumentSpan &args) {
+    auto &frame = frame_stack_.top();
+    auto lhs = FetchObjectView(args[0]);
+
+    if (frame.error) return;
+
+    if (lhs.Seek().GetTypeHandle() != kTypeHandleInt) {
+      frame.MakeError("Unsupported type");
+      return;
+    }
+
+    lhs.Seek().Cast<int64_t>() += inst.immediate;
+  }
+
+  void AASTMachine::OperatorDecreasing(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(2)) {
@@ -2087,7 +2703,7 @@ namespace sapphire {
 
     if (frame.error) return;
 
-    if (!compare(lhs.Seek().GetTypeId(), rhs.Seek().GetTypeId(), kTypeIdInt)) {
+    if (!compare(lhs.Seek().GetTypeHandle(), rhs.Seek().GetTypeHandle(), kTypeHandleInt)) {
       frame.MakeError("Unsupported type");
       return;
     }
@@ -2097,7 +2713,7 @@ namespace sapphire {
   }
 
   //TODO: Replace with multiple new commands
-  void AASTMachine::ExpList(ArgumentList &args) {
+  void AASTMachine::ExpList(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     if (!args.empty()) {
       auto result_view = FetchObjectView(args.back());
@@ -2105,7 +2721,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::InitArray(ArgumentList &args) {
+  void AASTMachine::InitArray(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
     ManagedArray base = make_shared<ObjectArray>();
 
@@ -2120,7 +2736,7 @@ namespace sapphire {
     frame.RefreshReturnStack(obj);
   }
 
-  void AASTMachine::CommandReturn(ArgumentList &args) {
+  void AASTMachine::CommandReturn(ArgumentSpan &args) {
     if (frame_stack_.size() == 1) {
       frame_stack_.top().MakeError("Unexpected return");
       return;
@@ -2198,7 +2814,7 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::CommandAssert(ArgumentList &args) {
+  void AASTMachine::CommandAssert(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(1)) {
@@ -2209,7 +2825,7 @@ namespace sapphire {
     auto &result_obj = FetchObjectView(args[0]).Seek();
     if (frame.error) return;
 
-    if (result_obj.GetTypeId() != kTypeIdBool) {
+    if (result_obj.GetTypeHandle() != kTypeHandleBool) {
       frame.MakeError("Invalid object type for assertion.");
       return;
     }
@@ -2219,12 +2835,12 @@ namespace sapphire {
     }
   }
 
-  void AASTMachine::DomainAssert(ArgumentList &args) {
+  void AASTMachine::DomainAssert(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
-    frame.assert_rc_copy = FetchObjectView(args[0]).Seek().Unpack();
+    frame.Detail().assert_rc_copy = FetchObjectView(args[0]).Seek().Unpack();
   }
 
-  //void AASTMachine::CommandHasBehavior(ArgumentList &args) {
+  //void AASTMachine::CommandHasBehavior(ArgumentSpan &args) {
   //  auto &frame = frame_stack_.top();
 
   //  auto &behavior_obj = FetchObjectView(args[1]).Seek();
@@ -2238,7 +2854,7 @@ namespace sapphire {
   //}
 
   template <ParameterPattern pattern>
-  void AASTMachine::CommandCheckParameterPattern(ArgumentList &args) {
+  void AASTMachine::CommandCheckParameterPattern(ArgumentSpan &args) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(1)) {
@@ -2252,181 +2868,235 @@ namespace sapphire {
     auto &func_obj = FetchObjectView(args[0]).Seek();
     if (frame.error) return;
 
-    if (func_obj.GetTypeId() != kTypeIdFunction) {
+    if (func_obj.GetTypeHandle() != kTypeHandleFunction) {
       frame.MakeError("Expected object type is function");
       return;
     }
 
     auto &impl = func_obj.Cast<Function>();
 
-    Object result(impl.IsVariableParam(), kTypeIdBool);
+    Object result(impl.IsVariableParam(), kTypeHandleBool);
     frame.RefreshReturnStack(result);
   }
 
-  void AASTMachine::MachineCommands(Operation operation, ArgumentList &args, ASTNode &node) {
+  void AASTMachine::CommandForEach(ArgumentSpan &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
 
-    switch (operation) {
-    case Operation::Load:
-      CommandLoad(args);
-      break;
-    case Operation::If:
-    case Operation::Elif:
+    if (frame.jump_from_end) {
+      CheckForEach(args, nest_end);
+      frame.jump_from_end = false;
+    }
+    else {
+      InitForEach(args, nest_end);
+    }
+  }
+
+  void AASTMachine::CommandEnd(Annotation &annotation) {
+    switch (annotation.nest_root) {
     case Operation::While:
-      CommandIfOrWhile(operation, args, node.annotation.nest_end);
-      break;
-    case Operation::Plus:
-      BinaryMathOperatorImpl<Operation::Plus>(args);
-      break;
-    case Operation::Minus:
-      BinaryMathOperatorImpl<Operation::Minus>(args);
-      break;
-    case Operation::Times:
-      BinaryMathOperatorImpl<Operation::Times>(args);
-      break;
-    case Operation::Divide:
-      BinaryMathOperatorImpl<Operation::Divide>(args);
-      break;
-    case Operation::Equals:
-      BinaryLogicOperatorImpl<Operation::Equals>(args);
-      break;
-    case Operation::LessOrEqual:
-      BinaryLogicOperatorImpl<Operation::LessOrEqual>(args);
-      break;
-    case Operation::GreaterOrEqual:
-      BinaryLogicOperatorImpl<Operation::GreaterOrEqual>(args);
-      break;
-    case Operation::NotEqual:
-      BinaryLogicOperatorImpl<Operation::NotEqual>(args);
-      break;
-    case Operation::Greater:
-      BinaryLogicOperatorImpl<Operation::Greater>(args);
-      break;
-    case Operation::Less:
-      BinaryLogicOperatorImpl<Operation::Less>(args);
-      break;
-    case Operation::And:
-      BinaryLogicOperatorImpl<Operation::And>(args);
-      break;
-    case Operation::Or:
-      BinaryLogicOperatorImpl<Operation::Or>(args);
-      break;
-    case Operation::Increase:
-      OperatorIncreasing(args);
-      break;
-    case Operation::Decrease:
-      OperatorDecreasing(args);
-      break;
-    case Operation::Not:
-      OperatorLogicNot(args);
+      CommandLoopEnd(annotation.nest);
       break;
     case Operation::For:
-      if (frame.jump_from_end) {
-        CheckForEach(args, node.annotation.nest_end);
-        frame.jump_from_end = false;
-      }
-      else {
-        InitForEach(args, node.annotation.nest_end);
-      }
-      break;
-    case Operation::Swap:
-      CommandSwap(args);
-      break;
-    case Operation::Bind:
-      CommandBind(args, node.annotation.local_object, node.annotation.ext_object);
-      break;
-    case Operation::Delivering:
-      CommandDelivering(args, node.annotation.local_object, node.annotation.ext_object);
-      break;
-    case Operation::ExpList:
-      ExpList(args);
-      break;
-    case Operation::InitialArray:
-      InitArray(args);
-      break;
-    case Operation::Return:
-      CommandReturn(args);
-      break;
-    case Operation::Assert:
-      CommandAssert(args);
-      break;
-    case Operation::TypeId:
-      CommandTypeId(args);
-      break;
-    case Operation::Fn:
-      ClosureCatching(args, node.annotation.nest_end, frame_stack_.size() > 1);
+      CommandForEachEnd(annotation.nest);
       break;
+    case Operation::If:
     case Operation::Case:
-      CommandCase(args, node.annotation.nest_end);
-      break;
-    case Operation::When:
-      CommandWhen(args);
-      break;
-    case Operation::End:
-      switch (node.annotation.nest_root) {
-      case Operation::While:
-        CommandLoopEnd(node.annotation.nest);
-        break;
-      case Operation::For:
-        CommandForEachEnd(node.annotation.nest);
-        break;
-      case Operation::If:
-      case Operation::Case:
-        CommandConditionEnd();
-        break;
-      case Operation::Struct:
-        CommandStructEnd();
-        break;
-      case Operation::Module:
-        CommandModuleEnd();
-        break;
-      default:break;
-      }
-      break;
-    case Operation::Continue:
-    case Operation::Break:
-      CommandContinueOrBreak(operation, node.annotation.escape_depth);
-      break;
-    case Operation::Else:
-      CommandElse();
-      break;
-    case Operation::Using:
-      CommandUsing(args);
+      CommandConditionEnd();
       break;
     case Operation::Struct:
-      CommandStructBegin(args);
+      CommandStructEnd();
       break;
     case Operation::Module:
-      CommandModuleBegin(args);
-      break;
-    case Operation::DomainAssertCommand:
-      DomainAssert(args);
-      break;
-    case Operation::Include:
-      CommandInclude(args);
-      break;
-    case Operation::Super:
-      CommandSuper(args);
-      break;
-    case Operation::Attribute:
-      CommandAttribute(args);
-      break;
-    case Operation::IsVariableParam:
-      CommandCheckParameterPattern<ParameterPattern::Variable>(args);
-      break;
-    case Operation::Print:
-      CommandPrint(args);
-      break;
-    case Operation::PrintLine:
-      CommandPrint(args);
-      fputs("\n", VM_STDOUT);
+      CommandModuleEnd();
       break;
+    default:break;
+    }
+  }
+
+  // Command handlers, shared by switch dispatch and threaded dispatch.
+  // 'node' is current instruction and 'args' is its operand list.
+#define MACHINE_COMMANDS(X)                                                                 \
+  X(Load, CommandLoad(args))                                                                \
+  X(If, CommandIfOrWhile(Operation::If, args, node.annotation.nest_end))                    \
+  X(Elif, CommandIfOrWhile(Operation::Elif, args, node.annotation.nest_end))                \
+  X(While, CommandIfOrWhile(Operation::While, args, node.annotation.nest_end))              \
+  X(Plus, BinaryMathOperatorImpl<Operation::Plus>(node, args))                              \
+  X(Minus, BinaryMathOperatorImpl<Operation::Minus>(node, args))                            \
+  X(Times, BinaryMathOperatorImpl<Operation::Times>(node, args))                            \
+  X(Divide, BinaryMathOperatorImpl<Operation::Divide>(node, args))                          \
+  X(Equals, BinaryLogicOperatorImpl<Operation::Equals>(node, args))                         \
+  X(LessOrEqual, BinaryLogicOperatorImpl<Operation::LessOrEqual>(node, args))               \
+  X(GreaterOrEqual, BinaryLogicOperatorImpl<Operation::GreaterOrEqual>(node, args))         \
+  X(NotEqual, BinaryLogicOperatorImpl<Operation::NotEqual>(node, args))                     \
+  X(Greater, BinaryLogicOperatorImpl<Operation::Greater>(node, args))                       \
+  X(Less, BinaryLogicOperatorImpl<Operation::Less>(node, args))                             \
+  X(And, BinaryLogicOperatorImpl<Operation::And>(node, args))                               \
+  X(Or, BinaryLogicOperatorImpl<Operation::Or>(node, args))                                 \
+  X(Increase, OperatorIncreasing(args))                                                     \
+  X(Decrease, OperatorDecreasing(args))                                                     \
+  X(Not, OperatorLogicNot(args))                                                            \
+  X(For, CommandForEach(args, node.annotation.nest_end))                                    \
+  X(Swap, CommandSwap(args))                                                                \
+  X(Bind, CommandBind(args, node.annotation.local_object, node.annotation.ext_object))      \
+  X(Delivering, CommandDelivering(args, node.annotation.local_object, node.annotation.ext_object)) \
+  X(ExpList, ExpList(args))                                                                 \
+  X(InitialArray, InitArray(args))                                                          \
+  X(Return, CommandReturn(args))                                                            \
+  X(Assert, CommandAssert(args))                                                            \
+  X(TypeId, CommandTypeId(args))                                                            \
+  X(Fn, ClosureCatching(args, node.annotation.nest_end, frame_stack_.size() > 1))           \
+  X(Case, CommandCase(node, args))                                                          \
+  X(When, CommandWhen(args))                                                                \
+  X(End, CommandEnd(node.annotation))                                                       \
+  X(Continue, CommandContinueOrBreak(Operation::Continue, node.annotation.escape_depth))    \
+  X(Break, CommandContinueOrBreak(Operation::Break, node.annotation.escape_depth))          \
+  X(Else, CommandElse())                                                                    \
+  X(Using, CommandUsing(args))                                                              \
+  X(Struct, CommandStructBegin(args))                                                       \
+  X(Module, CommandModuleBegin(args))                                                       \
+  X(DomainAssertCommand, DomainAssert(args))                                                \
+  X(Include, CommandInclude(args))                                                          \
+  X(Super, CommandSuper(args))                                                              \
+  X(Attribute, CommandAttribute(args))                                                      \
+  X(IsVariableParam, CommandCheckParameterPattern<ParameterPattern::Variable>(args))        \
+  X(Print, CommandPrint(args, false))                                                       \
+  X(PrintLine, CommandPrint(args, true))                                                    \
+  X(ShortCircuit, CommandShortCircuit(args, node.annotation.nest_end))                      \
+  X(Unbind, CommandUnbind(args))                                                            \
+  X(CompareBranch, CommandCompareBranch(node, args))                                        \
+  X(IncreaseBy, OperatorIncreaseBy(node, args))                                             \
+  X(IntrinsicAt, CommandIntrinsic<Operation::IntrinsicAt>(node, args))                      \
+  X(IntrinsicSize, CommandIntrinsic<Operation::IntrinsicSize>(node, args))                  \
+  X(IntrinsicPush, CommandIntrinsic<Operation::IntrinsicPush>(node, args))                  \
+  X(IntrinsicPop, CommandIntrinsic<Operation::IntrinsicPop>(node, args))                    \
+  X(IntrinsicFind, CommandIntrinsic<Operation::IntrinsicFind>(node, args))                  \
+  X(IntrinsicInsert, CommandIntrinsic<Operation::IntrinsicInsert>(node, args))              \
+  X(IntrinsicEmpty, CommandIntrinsic<Operation::IntrinsicEmpty>(node, args))
+
+  void AASTMachine::MachineCommands(Instruction &node, ArgumentSpan &args) {
+#define COMMAND_CASE(_Op, ...) case Operation::_Op: __VA_ARGS__; break;
+    switch (node.operation) {
+    MACHINE_COMMANDS(COMMAND_CASE)
     default:
       break;
     }
+#undef COMMAND_CASE
+  }
+
+  template <Operation op>
+  void AASTMachine::ExecuteCommand(Instruction &node, ArgumentSpan &args) {
+#define COMMAND_BRANCH(_Op, ...) if constexpr (op == Operation::_Op) { __VA_ARGS__; } else
+    MACHINE_COMMANDS(COMMAND_BRANCH) {}
+#undef COMMAND_BRANCH
+  }
+
+  // Return is left to Run() as it switches back to calling frame
+  bool IsNativeCommand(Operation operation) {
+#define COMMAND_CASE(_Op, ...) case Operation::_Op:
+    switch (operation) {
+    MACHINE_COMMANDS(COMMAND_CASE)
+      return operation != Operation::Return;
+    default:
+      return false;
+    }
+#undef COMMAND_CASE
+  }
+
+  bool NativeRunner::Resumable() {
+    return !frame_.error && !frame_.warning && !frame_.stop_point && !frame_.suspended &&
+      &machine_.frame_stack_.top() == &frame_ && machine_.code_stack_.back() == &code_ &&
+      frame_.idx < code_.size();
+  }
+
+  void NativeRunner::BeginCommand(Instruction &inst) {
+    machine_.view_delegator_.clear();
+    frame_.return_stack.Release();
+    script_idx_ = inst.line;
+    frame_.void_call = inst.annotation.void_call;
+    frame_.current_code = &code_;
+    frame_.is_command = true;
+    executed_ += 1;
+  }
+
+  bool NativeRunner::FinishCommand(size_t idx) {
+    //switching to invoked script method is done by Run()
+    if (frame_.suspended || !frame_.FinishCommand(false)) return false;
+    return frame_.idx == idx + 1 && Resumable();
+  }
+
+  template <Operation op>
+  bool NativeRunner::Execute(size_t idx) {
+    auto &inst = code_[idx];
+    auto args = code_.GetArguments(inst);
+
+    BeginCommand(inst);
+    machine_.ExecuteCommand<op>(inst, args);
+    return FinishCommand(idx);
+  }
+
+  // Same lookup as FetchObjectView(), but only a living integer in place
+  // is accepted. Ref object is left to interpreter.
+  int64_t *NativeRunner::IntOperand(Operand &arg) {
+    if (arg.fetch != FetchKind::Named) return nullptr;
+
+    auto *ptr = machine_.FindNamedObject(arg);
+
+    if (ptr == nullptr || ptr->GetMode() != ObjectMode::Normal || !ptr->IsUnboxed() ||
+      ptr->GetTypeHandle() != kTypeHandleInt) {
+      return nullptr;
+    }
+
+    return &ptr->Cast<int64_t>();
+  }
+
+  bool NativeRunner::Step(size_t idx) {
+    BeginCommand(code_[idx]);
+    return FinishCommand(idx);
+  }
+
+  bool NativeRunner::PushInt(size_t idx, int64_t value) {
+    BeginCommand(code_[idx]);
+    frame_.RefreshReturnStack(Object(value, kTypeHandleInt));
+    return FinishCommand(idx);
+  }
+
+  bool NativeRunner::PushBool(size_t idx, bool value) {
+    BeginCommand(code_[idx]);
+    frame_.RefreshReturnStack(value);
+    return FinishCommand(idx);
+  }
+
+  // Branch half of CompareBranch, see CommandCompareBranch()
+  bool NativeRunner::Branch(size_t idx, bool state) {
+    BeginCommand(code_[idx]);
+    frame_.idx += 1;
+    auto &branch = code_[frame_.idx];
+    machine_.ConditionBranch(branch.operation, state, branch.annotation.nest_end);
+    return FinishCommand(idx);
+  }
+
+#define COMMAND_INSTANCE(_Op, ...) template bool NativeRunner::Execute<Operation::_Op>(size_t idx);
+  MACHINE_COMMANDS(COMMAND_INSTANCE)
+#undef COMMAND_INSTANCE
+
+  template <Operation op>
+  bool NativeCommandStep(NativeRunner &runner, size_t idx) {
+    return runner.Execute<op>(idx);
+  }
+
+  NativeStep GetNativeStep(Operation operation) {
+    if (!IsNativeCommand(operation)) return nullptr;
+
+#define COMMAND_CASE(_Op, ...) case Operation::_Op: return NativeCommandStep<Operation::_Op>;
+    switch (operation) {
+    MACHINE_COMMANDS(COMMAND_CASE)
+    default:
+      return nullptr;
+    }
+#undef COMMAND_CASE
   }
 
-  void AASTMachine::GenerateArgs2(Function &impl, ArgumentList &args, ObjectMap &obj_map) {
+  void AASTMachine::GenerateArgs2(Function &impl, ArgumentSpan &args, CallArguments &arg_list) {
     auto &frame = frame_stack_.top();
     auto &params = impl.AccessParameters();
     
@@ -2447,7 +3117,7 @@ namespace sapphire {
       for (auto it = params.rbegin(); it != params.rend(); ++it) {
         view = FetchObjectView(args[pos]);
         view.Seek().RemoveDeliveringFlag();
-        obj_map.emplace(NamedObject(*it, view.Seek()));
+        arg_list.emplace_back(view.Seek());
         pos -= 1;
       }
     }
@@ -2475,35 +3145,81 @@ namespace sapphire {
         temp_list.clear();
       }
 
-      obj_map.insert(NamedObject(params.back(), Object(va_base, kTypeIdArray)));
+      arg_list.emplace_back(Object(va_base, kTypeHandleArray));
 
 
       while (pos > 0) {
-        obj_map.emplace(params[pos - 1], FetchObjectView(args[pos - 1]).Dump().RemoveDeliveringFlag());
+        arg_list.emplace_back(FetchObjectView(args[pos - 1]).Dump().RemoveDeliveringFlag());
         pos -= 1;
       }
     }
   }
 
+  void AASTMachine::GenerateArgs2(Function &impl, ArgumentSpan &args, ObjectMap &obj_map) {
+    CallArguments arg_list;
+
+    GenerateArgs2(impl, args, arg_list);
+    arg_list.ExportTo(impl.AccessParameters(), obj_map);
+  }
+
+  // Scope of user-defined function: calling marker, arguments, objects
+  // provided by caller (me, super struct) and closure scope
+  void AASTMachine::BindCallScope(Function &impl, ObjectMap &obj_map, CallArguments &arg_list) {
+    static const size_t marker_token = TryAppendTokenId(kStrUserFunc);
+
+    auto &frame = frame_stack_.top();
+    auto &code = *impl.GetCode();
+    auto &tokens = impl.AccessParameterTokens();
+    auto &param_slots = impl.AccessParameterSlots();
+    auto scope = obj_stack_.GetScopeSerial();
+
+    //parameters are read by index from the very first time
+    auto fill_slots = [&](size_t pos, ObjectPointer ptr) -> void {
+      auto version = GetBindingVersion(tokens[pos]);
+      auto group = param_slots[pos];
+      if (group.named != kNoSlot) frame.GetSlot(code, group.named).Fill(ptr, version, scope);
+      if (group.domain != kNoSlot) frame.GetSlot(code, group.domain).Fill(ptr, version, scope);
+    };
+
+    obj_stack_.CreateObject(kStrUserFunc, Object(impl.GetId()), marker_token);
+    obj_stack_.BindArguments(impl.AccessParameters(), tokens, arg_list, fill_slots);
+    obj_stack_.MergeMap(obj_map);
+    obj_stack_.MergeMap(impl.scope);
+  }
+
 
   void AASTMachine::GenerateStructInstance(ObjectMap &p) {
     auto &frame = frame_stack_.top();
 
-    auto &base = frame.struct_base.Cast<ObjectStruct>().GetContent();
-    auto managed_instance = make_shared<ObjectStruct>();
-    auto struct_id = base.at(kStrStructId).Cast<string>();
+    auto &base = frame.Detail().struct_base.Cast<ObjectStruct>();
+    auto managed_instance = base.GetShape() != nullptr ?
+      make_shared<ObjectStruct>(base.GetShape()) : make_shared<ObjectStruct>();
+    auto struct_id = base.Find(kStrStructId)->Cast<string>();
     auto super_struct = [&]() -> Object {
-      auto it = base.find(kStrSuperStruct);
-      if (it == base.end()) return Object();
-      return it->second;
+      auto *ptr = base.Find(kStrSuperStruct);
+      if (ptr == nullptr) return Object();
+      return *ptr;
     }();
-
-    for (auto &unit : base) {
-      if (compare(unit.first, kStrInitializer, kStrStructId, kStrSuperStruct)) {
-        continue;
+    //plain numeric members are stored unboxed
+    auto make_member = [](Object &source) -> Object {
+      switch (source.GetTypeHandle()) {
+      case kTypeHandleInt: return Object(source.Cast<int64_t>(), kTypeHandleInt);
+      case kTypeHandleFloat: return Object(source.Cast<double>(), kTypeHandleFloat);
+      case kTypeHandleBool: return Object(source.Cast<bool>(), kTypeHandleBool);
+      default: return components::DumpObject(source);
       }
+    };
 
-      managed_instance->Add(unit.first, components::DumpObject(unit.second));
+    if (base.GetShape() != nullptr) {
+      for (size_t idx = 0; idx < base.GetShape()->size(); idx += 1) {
+        managed_instance->GetSlot(idx) = make_member(base.GetSlot(idx));
+      }
+    }
+    else {
+      base.ForEach([&](const string &id, Object &obj) {
+        if (compare(id, kStrInitializer, kStrStructId, kStrSuperStruct)) return;
+        managed_instance->Replace(id, make_member(obj));
+      });
     }
 
     if (!super_struct.NullPtr()) {
@@ -2513,14 +3229,14 @@ namespace sapphire {
     Object instance_obj(managed_instance, struct_id);
     instance_obj.SetContainerFlag();
     p.insert(NamedObject(kStrMe, instance_obj));
-    frame.struct_base = Object();
+    frame.Detail().struct_base = Object();
   }
 
   void AASTMachine::GenerateErrorMessages(size_t stop_index) {
     //Under consideration
     if (frame_stack_.top().error) {
       //TODO:reporting function calling chain
-      AppendMessage(frame_stack_.top().msg_string, StateLevel::Error,
+      AppendMessage(frame_stack_.top().Detail().msg_string, StateLevel::Error,
         logger_, stop_index);
     }
 
@@ -2532,6 +3248,29 @@ namespace sapphire {
     }
   }
 
+  // Safe point of cycle collector, called between commands of outermost
+  // Run(). Objects viewed by operand stacks are kept with their containers.
+  // Collection runs between commands and never inside native calling, so
+  // no command holds a raw pointer at this point. Across commands, only
+  // views on return stacks can point into a tracked container, and these
+  // are pinned for this machine and every machine waiting on 'using'.
+  // Other pointers kept by frames don't need pinning: slots and call site
+  // caches point into scopes, which are never tracked, or are checked by
+  // serial of container before use. Arguments and 'me' live in the scope
+  // of callee, as owning copies or as refs through anchors, and for-each
+  // owns its container by keep-alive slot.
+  void AASTMachine::RunCollector() {
+    PinnedObjects pinned;
+
+    for (auto *machine = this; machine != nullptr; machine = machine->parent_) {
+      machine->frame_stack_.ForEach([&pinned](RuntimeFrame &frame) {
+        frame.return_stack.ForEachView([&pinned](ObjectPointer view) { pinned.insert(view); });
+      });
+    }
+
+    CollectCycles(pinned);
+  }
+
   //for extension callback facilities
   bool AASTMachine::PushObject(string id, Object object) {
     auto &frame = frame_stack_.top();
@@ -2561,13 +3300,16 @@ namespace sapphire {
     if (code_stack_.empty()) return;
 
     size_t script_idx = 0;
-    AnnotatedAST *code = code_stack_.back();
-    Sentense *sentense = nullptr;
+    Bytecode *code = code_stack_.back();
+    Instruction *inst = nullptr;
+    ArgumentSpan args;
     ObjectMap obj_map;
+    CallArguments arg_list;
     FunctionPointer impl;
+    bool jit = runtime::IsJitEnabled();
 
     if (!invoke) {
-      frame_stack_.push(RuntimeFrame());
+      frame_stack_.push();
       obj_stack_.Push();
       if (!delegated_base_scope_) CopyComponents();
     }
@@ -2576,54 +3318,48 @@ namespace sapphire {
     size_t size = code->size();
 
     obj_map.reserve(10);
+    arg_list.reserve(10);
+    frame->return_stack.Reserve(code->GetStackDepth());
 
     //Refreshing loop tick state to make it work correctly.
     auto refresh_tick = [&]() -> void {
       code = code_stack_.back();
       size = code->size();
       frame = &frame_stack_.top();
+      frame->return_stack.Reserve(code->GetStackDepth());
     };
     //Protect current runtime environment and load another function
     auto update_stack_frame = [&](Function &func) -> void {
       bool inside_initializer_calling = frame->do_initializer_calling;
       frame->do_initializer_calling = false;
-      code_stack_.push_back(&func.Get<AnnotatedAST>());
-      frame_stack_.push(RuntimeFrame(func.GetId()));
+      code_stack_.push_back(func.GetCode());
+      frame_stack_.push();
       obj_stack_.Push();
-      obj_stack_.CreateObject(kStrUserFunc, Object(func.GetId()));
-      obj_stack_.MergeMap(obj_map);
-      obj_stack_.MergeMap(impl->scope);
+      BindCallScope(func, obj_map, arg_list);
       refresh_tick();
-      frame->jump_offset = func.GetOffset();
       frame->inside_initializer_calling = inside_initializer_calling;
     };
     //Convert current environment to next self-calling 
     auto tail_recursion = [&]() -> void {
-      string function_scope = frame_stack_.top().function_scope;
-      size_t jump_offset = frame_stack_.top().jump_offset;
       obj_map.Naturalize(obj_stack_.GetCurrent());
-      frame_stack_.top() = RuntimeFrame(function_scope);
-      obj_stack_.ClearCurrent();
-      obj_stack_.CreateObject(kStrUserFunc, Object(function_scope));
-      obj_stack_.MergeMap(obj_map);
-      obj_stack_.MergeMap(impl->scope);
+      arg_list.Naturalize(obj_stack_.GetCurrent());
+      frame_stack_.top().Reset();
+      obj_stack_.RenewCurrent();
+      BindCallScope(*impl, obj_map, arg_list);
       refresh_tick();
-      frame->jump_offset = jump_offset;
     };
     //Convert current environment to next calling
     auto tail_call = [&](Function &func) -> void {
       code_stack_.pop_back();
-      code_stack_.push_back(&func.Get<AnnotatedAST>());
+      code_stack_.push_back(func.GetCode());
       obj_map.Naturalize(obj_stack_.GetCurrent());
+      arg_list.Naturalize(obj_stack_.GetCurrent());
       //auto inside_initiailizer_calling = frame_stack_.top().do_initializer_calling;
-      frame_stack_.top() = RuntimeFrame(func.GetId());
+      frame_stack_.top().Reset();
       //frame_stack_.top().inside_initializer_calling = inside_initiailizer_calling;
-      obj_stack_.ClearCurrent();
-      obj_stack_.CreateObject(kStrUserFunc, Object(func.GetId()));
-      obj_stack_.MergeMap(obj_map);
-      obj_stack_.MergeMap(impl->scope);
+      obj_stack_.RenewCurrent();
+      BindCallScope(func, obj_map, arg_list);
       refresh_tick();
-      frame->jump_offset = func.GetOffset();
     };
 
     auto load_function_impl = [&]() -> pair<bool, bool> {
@@ -2633,9 +3369,10 @@ namespace sapphire {
 
       switch (impl->GetType()) {
       case FunctionType::UserDef:
-        if (IsTailRecursion(frame->idx, &impl->Get<AnnotatedAST>())) tail_recursion();
+        if (IsTailRecursion(frame->idx, impl->GetCode())) tail_recursion();
         else if (IsTailCall(frame->idx) && !frame->do_initializer_calling) tail_call(*impl);
         else {
+          if (!CheckCallDepth()) break;
           update_stack_frame(*impl);
         }
         switch_to_next_tick = true;
@@ -2658,19 +3395,79 @@ namespace sapphire {
     };
 
     auto cleanup_cache = [&]() -> void {
-      for (auto &unit : view_delegator_) delete unit;
       view_delegator_.clear();
+      frame->return_stack.Release();
     };
 
+    auto load_instruction = [&]() -> void {
+      inst = &(*code)[frame->idx];
+      args = code->GetArguments(*inst);
+      script_idx = inst->line;
+      // indicator for disposing returning value or not
+      frame->void_call = inst->annotation.void_call;
+      frame->current_code = code;
+      frame->is_command = inst->type == NodeType::Operation;
+    };
+
+    //returns false if error is occurred
+    auto finish_command = [&]() -> bool {
+      auto is_return = inst->operation == Operation::Return;
+
+      //switch to script method invoked by this command
+      if (frame->suspended) {
+        refresh_tick();
+        return true;
+      }
+
+      if (is_return) {
+        refresh_tick();
+        if (frame->suspended) ResumeOperation();
+        //resumed operation invoked another script method
+        if (frame->suspended) {
+          refresh_tick();
+          return !frame->error;
+        }
+      }
+
+      return frame->FinishCommand(is_return);
+    };
+
+#ifdef SAPPHIRE_THREADED_DISPATCH
+    static void *dispatch_table[static_cast<size_t>(Operation::Null) + 1];
+    static bool dispatch_table_ready = false;
+
+    if (!dispatch_table_ready) {
+      for (auto &unit : dispatch_table) unit = &&command_default;
+#define COMMAND_LABEL_ADDRESS(_Op, ...) \
+      dispatch_table[static_cast<size_t>(Operation::_Op)] = &&command_##_Op;
+      MACHINE_COMMANDS(COMMAND_LABEL_ADDRESS)
+#undef COMMAND_LABEL_ADDRESS
+      dispatch_table_ready = true;
+    }
+
+    // Fast path between two commands. Anything else (stop point, warning,
+    // end of block, function calling) goes back to the top of main loop.
+    auto fetch_next_command = [&]() -> bool {
+      if (frame->stop_point || frame->warning || frame->idx >= size) return false;
+      if (GetCollectionDueFlag() && native_depth_ == 0) return false;
+      if ((*code)[frame->idx].type != NodeType::Operation) return false;
+      cleanup_cache();
+      load_instruction();
+      return true;
+    };
+#endif
+
     // Main loop of virtual machine.
     while (frame->idx < size || frame_stack_.size() > 1) {
       cleanup_cache();
 
+      if (GetCollectionDueFlag() && native_depth_ == 0) RunCollector();
+
       //break at stop point.
       if (frame->stop_point) break;
 
       if (frame->warning) {
-        AppendMessage(frame->msg_string, StateLevel::Warning, logger_);
+        AppendMessage(frame->Detail().msg_string, StateLevel::Warning, logger_);
         frame->warning = false;
       }
 
@@ -2683,48 +3480,80 @@ namespace sapphire {
         if (frame->error) break;
         //Update register data
         refresh_tick();
+        if (frame->suspended) ResumeOperation();
+        if (frame->error) break;
+        if (frame->suspended) {
+          refresh_tick();
+          continue;
+        }
         if (!frame->stop_point) {
           frame->Stepping();
         }
         continue;
       }
 
-      sentense = &(*code)[frame->idx];
-      script_idx = sentense->first.idx;
-      // indicator for disposing returning value or not
-      frame->void_call = sentense->first.annotation.void_call; 
-      frame->current_code = code;
-      frame->is_command = sentense->first.type == NodeType::Operation;
+      if (jit && code->Warm(kJitThreshold)) CompileNativeBlock(*code);
 
-      if (sentense->first.type == NodeType::Operation) {
-        MachineCommands(sentense->first.GetOperation(), sentense->second, sentense->first);
-        
-        auto is_return = sentense->first.GetOperation() == Operation::Return;
+      //translated code of this block runs until it meets a command
+      //which needs interpreter
+      if (auto native = code->GetNativeBlock(); native != nullptr) {
+        NativeRunner runner(*this, *frame, *code, script_idx);
 
-        if (is_return) refresh_tick();
-        if (frame->error) break;
-        if (!frame->stop_point) frame->Stepping();
-        if (!frame->cmd_value_returned && !is_return) {
-          frame->RefreshReturnStack(Object());
+        native(runner);
+
+        if (runner.Executed() != 0) {
+          if (!frame->suspended && frame->error) break;
+          refresh_tick();
+          continue;
+        }
+      }
+
+      load_instruction();
+
+      if (inst->type == NodeType::Operation) {
+#ifdef SAPPHIRE_THREADED_DISPATCH
+        // Every handler jumps to the handler of next command directly.
+#define COMMAND_LABEL(_Op, ...)                                                \
+      command_##_Op: {                                                         \
+          [[maybe_unused]] auto &node = *inst;                                 \
+          __VA_ARGS__;                                                         \
+          if (!finish_command()) break;                                        \
+          if (fetch_next_command()) goto *dispatch_table[static_cast<size_t>(inst->operation)]; \
+          continue;                                                            \
         }
-        frame->cmd_value_returned = false;
+
+        goto *dispatch_table[static_cast<size_t>(inst->operation)];
+        MACHINE_COMMANDS(COMMAND_LABEL)
+      command_default:
+        if (!finish_command()) break;
         continue;
+#undef COMMAND_LABEL
+#else
+        MachineCommands(*inst, args);
+        if (!finish_command()) break;
+        continue;
+#endif
       }
       else {
         obj_map.clear();
 
-        if (sentense->first.type == NodeType::Function) {
-          if (!FetchFunctionImpl(impl, sentense, obj_map)) {
+        if (inst->type == NodeType::Function) {
+          if (!FetchFunctionImpl(impl, inst, obj_map)) {
             break;
           }
         }
 
-        GenerateArgs2(*impl, sentense->second, obj_map);
+        arg_list.clear();
+        GenerateArgs2(*impl, args, arg_list);
+        if (impl->GetType() != FunctionType::UserDef) {
+          arg_list.ExportTo(impl->AccessParameters(), obj_map);
+        }
         if (frame->do_initializer_calling) GenerateStructInstance(obj_map);
         if (frame->error) break;
 
 
         auto result = load_function_impl();
+        arg_list.clear();
         if (frame->error) break;
         if (result.first) continue;
 
@@ -2737,7 +3566,7 @@ namespace sapphire {
     }
 
     if (frame->error) {
-      AppendMessage(frame->msg_string, StateLevel::Error, logger_, script_idx);
+      AppendMessage(frame->Detail().msg_string, StateLevel::Error, logger_, script_idx);
     }
 
     error_ = frame->error;
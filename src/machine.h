@@ -20,27 +20,112 @@ namespace sapphire {
   void InitPlainTypesAndConstants();
   void ActivateComponents();
 
-  using ResultTraitKey = pair<PlainType, PlainType>;
-  using TraitUnit = pair<ResultTraitKey, PlainType>;
-  const map<ResultTraitKey, PlainType> kResultDynamicTraits = {
-    TraitUnit(ResultTraitKey(PlainType::Int, PlainType::Int), PlainType::Int),
-    TraitUnit(ResultTraitKey(PlainType::Int, PlainType::Float), PlainType::Float),
-    TraitUnit(ResultTraitKey(PlainType::Int, PlainType::String), PlainType::String),
-    TraitUnit(ResultTraitKey(PlainType::Int, PlainType::Bool), PlainType::Int),
-    TraitUnit(ResultTraitKey(PlainType::Float, PlainType::Float), PlainType::Float),
-    TraitUnit(ResultTraitKey(PlainType::Float, PlainType::Int), PlainType::Float),
-    TraitUnit(ResultTraitKey(PlainType::Float, PlainType::String), PlainType::String),
-    TraitUnit(ResultTraitKey(PlainType::Float, PlainType::Bool), PlainType::Float),
-    TraitUnit(ResultTraitKey(PlainType::String, PlainType::String), PlainType::String),
-    TraitUnit(ResultTraitKey(PlainType::String, PlainType::Int), PlainType::String),
-    TraitUnit(ResultTraitKey(PlainType::String, PlainType::Float), PlainType::String),
-    TraitUnit(ResultTraitKey(PlainType::String, PlainType::Bool), PlainType::String),
-    TraitUnit(ResultTraitKey(PlainType::Bool, PlainType::Bool), PlainType::Bool),
-    TraitUnit(ResultTraitKey(PlainType::Bool, PlainType::Int), PlainType::Int),
-    TraitUnit(ResultTraitKey(PlainType::Bool, PlainType::Float), PlainType::Float),
-    TraitUnit(ResultTraitKey(PlainType::Bool, PlainType::String), PlainType::String)
+  static_assert(static_cast<TypeHandle>(PlainType::Int) == kTypeHandleInt &&
+    static_cast<TypeHandle>(PlainType::Float) == kTypeHandleFloat &&
+    static_cast<TypeHandle>(PlainType::String) == kTypeHandleString &&
+    static_cast<TypeHandle>(PlainType::Bool) == kTypeHandleBool,
+    "PlainType must share values with built-in type handles");
+
+  // Result type of binary operator, indexed by [lhs - 1][rhs - 1]
+  constexpr PlainType kResultDynamicTraits[4][4] = {
+    //  Int                Float              String             Bool
+    { PlainType::Int,    PlainType::Float,  PlainType::String, PlainType::Int },    //Int
+    { PlainType::Float,  PlainType::Float,  PlainType::String, PlainType::Float },  //Float
+    { PlainType::String, PlainType::String, PlainType::String, PlainType::String }, //String
+    { PlainType::Int,    PlainType::Float,  PlainType::String, PlainType::Bool }    //Bool
   };
 
+  constexpr bool IsPlainTypeCode(PlainType type) {
+    return type >= PlainType::Int && type <= PlainType::Bool;
+  }
+
+  constexpr PlainType GetResultType(PlainType lhs, PlainType rhs) {
+    if (!IsPlainTypeCode(lhs) || !IsPlainTypeCode(rhs)) return PlainType::Invalid;
+    return kResultDynamicTraits[static_cast<int>(lhs) - 1][static_cast<int>(rhs) - 1];
+  }
+
+  inline PlainType FindTypeCode(TypeHandle type) {
+    return IsPlainTypeHandle(type) ? static_cast<PlainType>(type) : PlainType::Invalid;
+  }
+
+  inline bool IsIllegalStringOperator(Operation operation) {
+    return operation != Operation::Plus && operation != Operation::NotEqual
+      && operation != Operation::Equals;
+  }
+
+  inline int64_t IntProducer(Object &obj) {
+    int64_t result = 0;
+
+    if (obj.GetTypeHandle() == kTypeHandleInt) {
+      result = obj.Cast<int64_t>();
+    }
+    else {
+      switch (auto type = FindTypeCode(obj.GetTypeHandle()); type) {
+      case PlainType::Float:result = static_cast<int64_t>(obj.Cast<double>()); break;
+      case PlainType::Bool:result = obj.Cast<bool>() ? 1 : 0; break;
+      default:break;
+      }
+    }
+
+    return result;
+  }
+
+  inline double FloatProducer(Object &obj) {
+    double result = 0;
+
+    if (obj.GetTypeHandle() == kTypeHandleFloat) {
+      result = obj.Cast<double>();
+    }
+    else {
+      switch (auto type = FindTypeCode(obj.GetTypeHandle()); type) {
+      case PlainType::Int:result = static_cast<double>(obj.Cast<int64_t>()); break;
+      case PlainType::Bool:result = obj.Cast<bool>() ? 1.0 : 0.0; break;
+      default:break;
+      }
+    }
+
+    return result;
+  }
+
+  inline string StringProducer(Object &obj) {
+    string result;
+
+    if (obj.GetTypeHandle() == kTypeHandleString) {
+      result = obj.Cast<string>();
+    }
+    else {
+      switch (auto type = FindTypeCode(obj.GetTypeHandle()); type) {
+      case PlainType::Float:result = to_string(obj.Cast<double>()); break;
+      case PlainType::Bool:result = obj.Cast<bool>() ? kStrTrue : kStrFalse; break;
+      case PlainType::Int:result = to_string(obj.Cast<int64_t>()); break;
+      default:break;
+      }
+    }
+
+    return result;
+  }
+
+  inline bool BoolProducer(Object &obj) {
+    if (obj.GetTypeHandle() == kTypeHandleBool) {
+      return obj.Cast<bool>();
+    }
+
+    auto type = FindTypeCode(obj.GetTypeHandle());
+    bool result = false;
+
+
+    switch (type) {
+    case PlainType::Int: result = obj.Cast<int64_t>() > 0; break;
+    case PlainType::Float: result = obj.Cast<double>() > 0.0; break;
+    case PlainType::Bool: result = obj.Cast<bool>(); break;
+    case PlainType::String: result = !obj.Cast<string>().empty(); break;
+    default:
+      break;
+    }
+
+    return result;
+  }
+  
   template <typename ResultType, class Tx, class Ty, Operation op>
   struct BinaryOpBox {
     ResultType Do(Tx A, Ty B) {
@@ -175,14 +260,174 @@ namespace sapphire {
   template <typename Tx, Operation op>
   using LogicBox = BinaryOpBox<bool, Tx, Tx, op>;
 
+  // Generic operation of plain type objects, shared by virtual machine and
+  // constant folding. Null object is returned if operator is disposed for
+  // result type.
+  template <Operation op_code>
+  Object PlainMathOperation(Object &lhs, Object &rhs) {
+    auto result_type = GetResultType(FindTypeCode(lhs.GetTypeHandle()), FindTypeCode(rhs.GetTypeHandle()));
+
+#define RESULT_PROCESSING(_Type, _Func, _TypeId) \
+  return Object(MathBox<_Type, op_code>().Do(_Func(lhs), _Func(rhs)), _TypeId);
+
+    switch (result_type) {
+    case PlainType::String:
+      if (IsIllegalStringOperator(op_code)) return Object();
+      RESULT_PROCESSING(string, StringProducer, kTypeHandleString);
+    case PlainType::Int: RESULT_PROCESSING(int64_t, IntProducer, kTypeHandleInt);
+    case PlainType::Float: RESULT_PROCESSING(double, FloatProducer, kTypeHandleFloat);
+    case PlainType::Bool: RESULT_PROCESSING(bool, BoolProducer, kTypeHandleBool);
+    default: return Object();
+    }
+#undef RESULT_PROCESSING
+  }
+
+  template <Operation op_code>
+  Object PlainLogicOperation(Object &lhs, Object &rhs) {
+    auto result_type = GetResultType(FindTypeCode(lhs.GetTypeHandle()), FindTypeCode(rhs.GetTypeHandle()));
+    bool result = false;
+
+#define RESULT_PROCESSING(_Type, _Func) \
+  result = LogicBox<_Type, op_code>().Do(_Func(lhs), _Func(rhs));
+
+    switch (result_type) {
+    case PlainType::String:
+      if (IsIllegalStringOperator(op_code)) return Object();
+      RESULT_PROCESSING(string, StringProducer);
+      break;
+    case PlainType::Int: RESULT_PROCESSING(int64_t, IntProducer); break;
+    case PlainType::Float: RESULT_PROCESSING(double, FloatProducer); break;
+    case PlainType::Bool: RESULT_PROCESSING(bool, BoolProducer); break;
+    default: return Object();
+    }
+#undef RESULT_PROCESSING
+
+    return Object(result, kTypeHandleBool);
+  }
+
   const string kIteratorBehavior = "obj|step_forward|compare";
   const string kContainerBehavior = "head|tail|empty";
   const string kForEachExceptions = "!iterator|!container_keepalive";
 
-  using CommandPointer = Sentense * ;
+  using CommandPointer = Instruction * ;
+
+  // Entry of operand stack.
+  // Holds an object in place, or a view of an object living elsewhere.
+  struct StackValue {
+    Object value;
+    ObjectPointer view;
+
+    StackValue() : value(), view(nullptr) {}
+
+    bool IsObjectView() const { return view != nullptr; }
+    Object &Seek() { return view != nullptr ? *view : value; }
+    bool IsAlive() const { return view != nullptr ? view->IsAlive() : value.IsAlive(); }
+  };
+
+  // Operand stack of runtime frame.
+  // Slots are preallocated by the depth of code block and reused in place.
+  // A popped value is kept in its slot until Release() at the beginning of
+  // next tick (or until the slot is pushed again), so the view fetched by
+  // current instruction stays valid.
+  class OperandStack {
+  protected:
+    vector<StackValue> slots_;
+    size_t top_;
+    size_t dirty_;
+
+    StackValue &Next() {
+      if (top_ == slots_.size()) slots_.emplace_back(StackValue());
+      auto &slot = slots_[top_];
+      top_ += 1;
+      if (top_ > dirty_) dirty_ = top_;
+      return slot;
+    }
+
+    static void Assign(Object &dest, const Object &src) {
+      //reference link is bound to the address of object
+      if (dest.IsRef() || src.IsRef()) {
+        dest.~Object();
+        new (&dest) Object(src);
+      }
+      else {
+        dest = src;
+      }
+    }
+
+  public:
+    OperandStack() : slots_(), top_(0), dirty_(0) {}
+
+    void Reserve(size_t depth) {
+      if (slots_.size() < depth) slots_.resize(depth);
+    }
+
+    void Push(const Object &obj) {
+      auto &slot = Next();
+      slot.view = nullptr;
+      Assign(slot.value, obj);
+    }
+
+    void PushView(ObjectPointer ptr) {
+      auto &slot = Next();
+      slot.view = ptr;
+    }
+
+    void Release() {
+      for (size_t idx = top_; idx < dirty_; idx += 1) {
+        auto &slot = slots_[idx];
+        slot.view = nullptr;
+        if (!slot.value.NullPtr()) Assign(slot.value, Object());
+      }
+
+      dirty_ = top_;
+    }
+
+    void Clear() {
+      top_ = 0;
+      Release();
+    }
+
+    template <typename Visitor>
+    void ForEachView(Visitor visitor) {
+      for (size_t idx = 0; idx < top_; idx += 1) {
+        if (slots_[idx].IsObjectView()) visitor(slots_[idx].view);
+      }
+    }
+
+    StackValue &back() { return slots_[top_ - 1]; }
+    void pop_back() { top_ -= 1; }
+    bool empty() const { return top_ == 0; }
+    size_t size() const { return top_; }
+  };
+
+  // Method of script container which for-each is waiting for
+  enum class IterationStage { None, Empty, Head, Get, Step, Tail, Compare };
+
+  // Frame state which is only touched by struct/module definition, domain
+  // assertion and message reporting. It's allocated on first use and kept
+  // by pooled frame.
+  struct FrameDetail {
+    Object struct_base;
+    Object assert_rc_copy;
+    string msg_string;
+    string struct_id;
+    string super_struct_id;
+
+    void Reset();
+  };
 
   class RuntimeFrame {
   public:
+    // Per-call state, touched by almost every command
+    size_t idx;
+    Bytecode *current_code;
+    OperandStack return_stack;
+    vector<ObjectSlot> slots; //resolved identifiers, indexed by Operand::slot
+    JumpRecordStack jump_stack; //tracing the end of block
+    JumpRecordStack branch_jump_stack; //for else/when
+    stack<bool, vector<bool>> condition_stack; //assisted with jump stack
+    stack<bool, vector<bool>> scope_indicator; //is this block has scope
+    IterationStage iteration_stage;
     bool error;
     bool warning;
     bool from_continue;
@@ -198,22 +443,22 @@ namespace sapphire {
     bool keep_condition;
     bool is_command;
     bool cmd_value_returned;
-    AnnotatedAST *current_code;
-    Object struct_base;
-    Object assert_rc_copy;
-    size_t jump_offset;
-    size_t idx;
-    string msg_string;
-    string function_scope;
-    string struct_id;
-    string super_struct_id;
-    stack<bool> condition_stack; //assisted with jump stack
-    stack<bool> scope_indicator; //is this block has scope
-    stack<size_t> jump_stack; //tracing the end of block
-    stack<size_t> branch_jump_stack; //for else/when
-    vector<ObjectCommonSlot> return_stack;
+    bool suspended; //native operation is waiting for invoked script method
+
+  protected:
+    unique_ptr<FrameDetail> detail_;
 
-    RuntimeFrame(string scope = kStrRootScope) :
+  public:
+    RuntimeFrame() :
+      idx(0),
+      current_code(nullptr),
+      return_stack(),
+      slots(),
+      jump_stack(),
+      branch_jump_stack(),
+      condition_stack(),
+      scope_indicator(),
+      iteration_stage(IterationStage::None),
       error(false),
       warning(false),
       from_continue(false),
@@ -229,20 +474,26 @@ namespace sapphire {
       keep_condition(false),
       is_command(false),
       cmd_value_returned(false),
-      current_code(nullptr),
-      assert_rc_copy(),
-      jump_offset(0),
-      idx(0),
-      msg_string(),
-      function_scope(),
-      struct_id(),
-      super_struct_id(),
-      condition_stack(),
-      jump_stack(),
-      branch_jump_stack(),
-      return_stack() {}
+      suspended(false),
+      detail_() {}
+
+    FrameDetail &Detail() {
+      if (detail_ == nullptr) detail_ = make_unique<FrameDetail>();
+      return *detail_;
+    }
+
+    bool HasAssertedObject() const {
+      return detail_ != nullptr && !detail_->assert_rc_copy.NullPtr();
+    }
+
+    bool InsideStructDefinition() const {
+      return detail_ != nullptr && !detail_->struct_id.empty();
+    }
 
+    void Reset();
     void Stepping();
+    ObjectSlot &GetSlot(Bytecode &code, size_t slot);
+    bool FinishCommand(bool is_return);
     void Goto(size_t taget_idx);
 
     void AddJumpRecord(size_t target_idx);
@@ -257,10 +508,10 @@ namespace sapphire {
     template <class T>
     void RefreshReturnStack(T &value, string &type_id) {
       if (!void_call) {
-        return_stack.push_back(new Object(value, type_id));
+        return_stack.Push(Object(value, type_id));
       }
       if (stop_point) {
-        return_stack.push_back(new Object(value, type_id));
+        return_stack.Push(Object(value, type_id));
         has_return_value_from_invoking = true;
       }
     }
@@ -268,19 +519,24 @@ namespace sapphire {
     template <class T>
     void RefreshReturnStack(T &&value, string &type_id) {
       if (!void_call) {
-        return_stack.push_back(new Object(std::forward<T>(value), type_id));
+        return_stack.Push(Object(std::forward<T>(value), type_id));
       }
       if (stop_point) {
-        return_stack.push_back(new Object(std::forward<T>(value), type_id));
+        return_stack.Push(Object(std::forward<T>(value), type_id));
         has_return_value_from_invoking = true;
       }
     }
   };
 
+  // Nested Run() for script method called by native code synchronously.
+  // Each level costs native stack, so it's limited regardless of
+  // call depth limit.
+  const size_t kNativeCallDepthMax = 200;
+
   //light frame for component function calling
   class State {
   protected:
-    vector<ObjectCommonSlot> *return_stack_;
+    OperandStack *return_stack_;
     bool void_return;
     bool value_returned_;
     ObjectStack *obj_stack_;
@@ -298,28 +554,28 @@ namespace sapphire {
 
     void PushValue(Object &obj) {
       if (!void_return) {
-        return_stack_->push_back(new Object(obj));
+        return_stack_->Push(obj);
         value_returned_ = true;
       }
     }
     
     void PushValue(Object &&obj) {
       if (!void_return) {
-        return_stack_->push_back(new Object(std::move(obj)));
+        return_stack_->Push(obj);
         value_returned_ = true;
       }
     }
 
     void PushView(ObjectView view) {
       if (!void_return) {
-        return_stack_->push_back(new ObjectView(view));
+        return_stack_->PushView(&view.Seek());
         value_returned_ = true;
       }
     }
 
     void PushView(Object &obj) {
       if (!void_return) {
-        return_stack_->push_back(new ObjectView(&obj));
+        return_stack_->PushView(&obj);
         value_returned_ = true;
       }
     }
@@ -333,9 +589,42 @@ namespace sapphire {
     bool HasValueReturned() const { return  value_returned_; }
   };
 
-  using FrameStack = stack<RuntimeFrame, deque<RuntimeFrame>>;
+  // Pool of runtime frames.
+  // Popped frame is reset and kept for next calling, so a call only costs
+  // re-initialization of flags instead of allocating stacks and strings.
+  // Frames are stored in deque and never move while the pool grows.
+  class FrameStack {
+  protected:
+    deque<RuntimeFrame> frames_;
+    size_t top_;
+
+  public:
+    FrameStack() : frames_(), top_(0) {}
+
+    RuntimeFrame &push() {
+      if (top_ == frames_.size()) frames_.emplace_back(RuntimeFrame());
+      top_ += 1;
+      return frames_[top_ - 1];
+    }
+
+    void pop() {
+      top_ -= 1;
+      frames_[top_].Reset();
+    }
+
+    RuntimeFrame &top() { return frames_[top_ - 1]; }
+    bool empty() const { return top_ == 0; }
+    size_t size() const { return top_; }
+
+    template <typename Visitor>
+    void ForEach(Visitor visitor) {
+      for (size_t idx = 0; idx < top_; idx += 1) visitor(frames_[idx]);
+    }
+  };
 
   class AASTMachine {
+    friend class NativeRunner;
+
   protected:
     StandardLogger *logger_;
     bool is_logger_host_;
@@ -343,11 +632,13 @@ namespace sapphire {
   protected:
     void RecoverLastState(bool call_by_return);
     void FinishInitalizerCalling();
-    bool IsTailRecursion(size_t idx, AnnotatedAST *code);
+    bool IsTailRecursion(size_t idx, Bytecode *code);
     bool IsTailCall(size_t idx);
 
     Object *FetchLiteralObject(Argument &arg);
-    ObjectView FetchObjectView(Argument &arg);
+    ObjectPointer FindNamedObject(Operand &arg, bool binding_target = false);
+    ObjectPointer FindMemberObject(Operand &arg);
+    ObjectView FetchObjectView(Operand &arg);
     bool CheckObjectBehavior(Object &obj, string behaviors);
     bool CheckObjectMethod(Object &obj, string id);
 
@@ -357,72 +648,111 @@ namespace sapphire {
     bool FetchFunctionImpl(FunctionPointer &impl, CommandPointer &command,
       ObjectMap &obj_map);
 
-    void CheckObjectWithDomain(Function &impl, ASTNode &req, bool first_assert);
-    void CheckArgrumentList(Function &impl, ArgumentList &args);
-    void ClosureCatching(ArgumentList &args, size_t nest_end, bool closure);
+    void CheckObjectWithDomain(Function &impl, Instruction &inst, CallSite &site, bool first_assert);
+    void CheckArgrumentList(Function &impl, ArgumentSpan &args);
+    void ClosureCatching(ArgumentSpan &args, size_t nest_end, bool closure);
     
     optional<Object> CallMethod2(Object &obj, string id, ObjectMap &args);
     optional<Object> CallMethod2(Object &obj, string id, const initializer_list<NamedObject> &&args);
     optional<Object> CallUserDefinedFunction(Function &impl, ObjectMap &obj_map);
-
-    void CommandLoad(ArgumentList &args);
-    void CommandIfOrWhile(Operation token, ArgumentList &args, size_t nest_end);
-    void InitForEach(ArgumentList &args, size_t nest_end);
-    void CheckForEach(ArgumentList &args, size_t nest_end);
+    optional<Object> InvokeMethod(Object &obj, string id, ObjectMap &args);
+    optional<Object> InvokeMethod(Object &obj, string id, const initializer_list<NamedObject> &&args);
+    void ResumeOperation();
+    bool FetchCompareResult(optional<Object> &result, Operation operation, bool &value);
+    bool CheckCallDepth();
+
+    void CommandLoad(ArgumentSpan &args);
+    void CommandIfOrWhile(Operation token, ArgumentSpan &args, size_t nest_end);
+    void ConditionBranch(Operation token, bool state, size_t nest_end);
+    void CommandCompareBranch(Instruction &inst, ArgumentSpan &args);
+    void CommandShortCircuit(ArgumentSpan &args, size_t nest_end);
+    void CommandUnbind(ArgumentSpan &args);
+    template <Operation op>
+    void CommandIntrinsic(Instruction &inst, ArgumentSpan &args);
+    void IntrinsicFallback(Instruction &inst, ArgumentSpan &args);
+    void InitForEach(ArgumentSpan &args, size_t nest_end);
+    void CheckForEach(ArgumentSpan &args, size_t nest_end);
+    void IterateScriptContainer(IterationStage stage, optional<Object> result);
+    void CommandForEach(ArgumentSpan &args, size_t nest_end);
     
-    void CommandCase(ArgumentList &args, size_t nest_end);
+    void CommandCase(Instruction &inst, ArgumentSpan &args);
     void CommandElse();
-    void CommandWhen(ArgumentList &args);
+    void CommandWhen(ArgumentSpan &args);
     void CommandContinueOrBreak(Operation token, size_t escape_depth);
-    void CommandStructBegin(ArgumentList &args);
-    void CommandModuleBegin(ArgumentList &args);
+    void CommandStructBegin(ArgumentSpan &args);
+    void CommandModuleBegin(ArgumentSpan &args);
+    void CommandEnd(Annotation &annotation);
     void CommandConditionEnd();
     void CommandLoopEnd(size_t nest);
     void CommandForEachEnd(size_t nest);
     void CommandStructEnd();
     void CommandModuleEnd();
-    void CommandInclude(ArgumentList &args);
-    void CommandSuper(ArgumentList &args);
-    void CommandAttribute(ArgumentList &args);
+    void CommandInclude(ArgumentSpan &args);
+    void CommandSuper(ArgumentSpan &args);
+    void CommandAttribute(ArgumentSpan &args);
+
+    void CommandSwap(ArgumentSpan &args);
+    void CommandSwapIf(ArgumentSpan &args);
+    void CommandBind(ArgumentSpan &args, bool local_value, bool ext_value);
+    void CommandDelivering(ArgumentSpan &args, bool local_value, bool ext_value);
+    void CommandTypeId(ArgumentSpan &args);
+
+    void CommandUsing(ArgumentSpan &args);
+    void PrintObject(ArgumentSpan &args);
+    void CommandPrint(ArgumentSpan &args, bool new_line);
+    void CommandSleep(ArgumentSpan &args);
 
-    void CommandSwap(ArgumentList &args);
-    void CommandSwapIf(ArgumentList &args);
-    void CommandBind(ArgumentList &args, bool local_value, bool ext_value);
-    void CommandDelivering(ArgumentList &args, bool local_value, bool ext_value);
-    void CommandTypeId(ArgumentList &args);
+    template <Operation op_code>
+    void QuickMathOperator(TypeHandle type, Object &lhs, Object &rhs);
 
-    void CommandUsing(ArgumentList &args);
-    void CommandPrint(ArgumentList &args);
-    void CommandSleep(ArgumentList &args);
+    template <Operation op_code>
+    bool QuickLogicOperator(TypeHandle type, Object &lhs, Object &rhs, bool &result);
 
     template <Operation op_code>
-    void BinaryMathOperatorImpl(ArgumentList &args);
+    void BinaryMathOperatorImpl(Instruction &inst, ArgumentSpan &args);
 
     template <Operation op_code>
-    void BinaryLogicOperatorImpl(ArgumentList &args);
+    void BinaryLogicOperation(Instruction &inst, ObjectView &lhs, ObjectView &rhs);
 
-    void OperatorIncreasing(ArgumentList &args);
-    void OperatorDecreasing(ArgumentList &args);
-    void OperatorLogicNot(ArgumentList &args);
+    template <Operation op_code>
+    void BinaryLogicOperatorImpl(Instruction &inst, ArgumentSpan &args);
 
-    void ExpList(ArgumentList &args);
-    void InitArray(ArgumentList &args);
-    void CommandReturn(ArgumentList &args);
-    void CommandAssert(ArgumentList &args);
-    void DomainAssert(ArgumentList &args);
+    template <Operation op_code>
+    bool CompareOperands(Instruction &inst, ArgumentSpan &args, bool &state);
+
+    void OperatorIncreasing(ArgumentSpan &args);
+    void OperatorIncreaseBy(Instruction &inst, ArgumentSpan &args);
+    void OperatorDecreasing(ArgumentSpan &args);
+    void OperatorLogicNot(ArgumentSpan &args);
+
+    void ExpList(ArgumentSpan &args);
+    void InitArray(ArgumentSpan &args);
+    void CommandReturn(ArgumentSpan &args);
+    void CommandAssert(ArgumentSpan &args);
+    void DomainAssert(ArgumentSpan &args);
     template <ParameterPattern pattern>
-    void CommandCheckParameterPattern(ArgumentList &args);
+    void CommandCheckParameterPattern(ArgumentSpan &args);
 
-    void MachineCommands(Operation token, ArgumentList &args, ASTNode &request);
+    void MachineCommands(Instruction &inst, ArgumentSpan &args);
 
-    void GenerateArgs2(Function &impl, ArgumentList &args, ObjectMap &obj_map);
+    template <Operation op>
+    void ExecuteCommand(Instruction &node, ArgumentSpan &args);
+
+    void GenerateArgs2(Function &impl, ArgumentSpan &args, CallArguments &arg_list);
+    void GenerateArgs2(Function &impl, ArgumentSpan &args, ObjectMap &obj_map);
+    void BindCallScope(Function &impl, ObjectMap &obj_map, CallArguments &arg_list);
+    void FillLocalSlots(Operand &target, ObjectPointer ptr);
     void GenerateStructInstance(ObjectMap &p);
     void GenerateErrorMessages(size_t stop_index);
+    void RunCollector();
   protected:
-    deque<AASTPointer> code_stack_;
+    deque<BytecodePointer> code_stack_;
     FrameStack frame_stack_;
     ObjectStack obj_stack_;
-    vector<ObjectCommonSlot> view_delegator_;
+    deque<Object> view_delegator_;
+    // Machine waiting for this one to finish script loaded by 'using'
+    AASTMachine *parent_;
+    size_t native_depth_;
     bool delegated_base_scope_;
     bool error_;
     
@@ -435,12 +765,15 @@ namespace sapphire {
     void operator=(const AASTMachine &) = delete;
     void operator=(const AASTMachine &&) = delete;
 
-    AASTMachine(AnnotatedAST &ir, string log_path, bool rtlog = false) :
+    AASTMachine(Bytecode &ir, string log_path, bool rtlog = false) :
       logger_(nullptr),
       is_logger_host_(true),
       code_stack_(),
       frame_stack_(),
       obj_stack_(),
+      view_delegator_(),
+      parent_(nullptr),
+      native_depth_(0),
       delegated_base_scope_(false),
       error_(false) { 
 
@@ -450,12 +783,15 @@ namespace sapphire {
         (StandardLogger *)new StandardCachedLogger(log_path, "a");
     }
 
-    AASTMachine(AnnotatedAST &ir, StandardLogger *logger) :
+    AASTMachine(Bytecode &ir, StandardLogger *logger) :
       logger_(logger),
       is_logger_host_(false),
       code_stack_(),
       frame_stack_(),
       obj_stack_(),
+      view_delegator_(),
+      parent_(nullptr),
+      native_depth_(0),
       delegated_base_scope_(false),
       error_(false) {
 
@@ -476,8 +812,62 @@ namespace sapphire {
       delegated_base_scope_ = true;
     }
 
+    // Native calling of parent is still on C++ stack, so it counts for
+    // depth limit and blocks collection here as well
+    void SetParentMachine(AASTMachine &parent) {
+      parent_ = &parent;
+      native_depth_ = parent.native_depth_;
+    }
+
     bool ErrorOccurred() const {
       return error_;
     }
   };
+
+  // Commands which can be executed by translated code
+  bool IsNativeCommand(Operation operation);
+
+  class NativeRunner;
+  // Entry of one command for compiled code
+  using NativeStep = bool (*)(NativeRunner &runner, size_t idx);
+  NativeStep GetNativeStep(Operation operation);
+
+  // Execution state of current block lent to translated code.
+  // Translated code executes commands one after another and returns to
+  // Run() at function calling, suspension, error, warning and stop point.
+  class NativeRunner {
+  protected:
+    AASTMachine &machine_;
+    RuntimeFrame &frame_;
+    Bytecode &code_;
+    size_t &script_idx_;
+    size_t executed_;
+
+  public:
+    NativeRunner() = delete;
+    NativeRunner(AASTMachine &machine, RuntimeFrame &frame, Bytecode &code, size_t &script_idx) :
+      machine_(machine), frame_(frame), code_(code), script_idx_(script_idx), executed_(0) {}
+
+    size_t Index() const { return frame_.idx; }
+    size_t Executed() const { return executed_; }
+    bool Resumable();
+
+    // Returns true if next command can be executed in place
+    template <Operation op>
+    bool Execute(size_t idx);
+
+    // Pieces of commands which are done by machine code templates.
+    // Value of an integer operand is loaded in place, nullptr means the
+    // operand is not an unboxed integer and command has to be executed by
+    // Execute(). Rest of them finish command with result of machine code.
+    int64_t *IntOperand(Operand &arg);
+    bool Step(size_t idx);
+    bool PushInt(size_t idx, int64_t value);
+    bool PushBool(size_t idx, bool value);
+    bool Branch(size_t idx, bool state);
+
+  protected:
+    void BeginCommand(Instruction &inst);
+    bool FinishCommand(size_t idx);
+  };
 }
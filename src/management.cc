@@ -9,7 +9,7 @@ namespace sapphire::components {
 
   void CreateFunctionObject(Function impl) {
     auto &base = GetBuiltinComponentsObjBase();
-    base.try_emplace(impl.GetId(), Object(impl, kTypeIdFunction));
+    base.try_emplace(impl.GetId(), Object(impl, kTypeHandleFunction));
   }
 
   //We don't need FindFunction() in new implementation.
@@ -21,7 +21,7 @@ namespace sapphire::components {
   void CreateStruct(string id) {
     auto &base = GetBuiltinComponentsObjBase();
     auto obj_struct = make_shared<ObjectStruct>();
-    auto result = base.try_emplace(id, Object(obj_struct, kTypeIdStruct));
+    auto result = base.try_emplace(id, Object(obj_struct, kTypeHandleStruct));
     auto &struct_base = result.first->second.Cast<ObjectStruct>();
     struct_base.Add(kStrStructId, Object(id));
   }
@@ -35,35 +35,44 @@ namespace sapphire::components {
     auto &struct_base = it->second.Cast<ObjectStruct>();
     
     for (auto &unit : impls) {
-      struct_base.Add(unit.GetId(), Object(make_shared<Function>(unit), kTypeIdFunction));
+      struct_base.Add(unit.GetId(), Object(make_shared<Function>(unit), kTypeHandleFunction));
     }
 
     return true;
   }
 
   void DumpObject(ObjectView source, ObjectView dest) {
-    if (!lexical::IsPlainType(source.Seek().GetTypeId())) {
+    if (!IsPlainTypeHandle(source.Seek().GetTypeHandle())) {
       dest.Seek() = source.Seek();
       return;
     }
 
-    auto type_id = source.Seek().GetTypeId();
+    auto type = source.Seek().GetTypeHandle();
+
+    //box of destination can be overwritten if nobody else is sharing it
+    auto &dest_obj = dest.Seek().Unpack();
+    bool reuse_box = dest_obj.GetTypeHandle() == type && !dest_obj.IsUnboxed() &&
+      dest_obj.use_count() == 1;
+    //unboxed destination keeps value inside itself
+    bool keep_unboxed = dest_obj.IsUnboxed() && type != kTypeHandleString;
 
 #define DUMP_VALUE(_Type, _Id)                                \
     auto &value = source.Seek().Cast<_Type>();                \
-    dest.Seek().PackContent(make_shared<_Type>(value), _Id);
+    if (reuse_box) dest_obj.Cast<_Type>() = value;            \
+    else if (keep_unboxed) dest_obj = Object(value, _Id);     \
+    else dest.Seek().PackContent(make_shared<_Type>(value), _Id);
 
-    if (type_id == kTypeIdInt) {
-      DUMP_VALUE(int64_t, kTypeIdInt)
+    if (type == kTypeHandleInt) {
+      DUMP_VALUE(int64_t, kTypeHandleInt)
     }
-    else if (type_id == kTypeIdFloat) {
-      DUMP_VALUE(double, kTypeIdFloat)
+    else if (type == kTypeHandleFloat) {
+      DUMP_VALUE(double, kTypeHandleFloat)
     }
-    else if (type_id == kTypeIdString) {
-      DUMP_VALUE(string, kTypeIdString)
+    else if (type == kTypeHandleString) {
+      DUMP_VALUE(string, kTypeHandleString)
     }
-    else if (type_id == kTypeIdBool) {
-      DUMP_VALUE(bool, kTypeIdBool)
+    else if (type == kTypeHandleBool) {
+      DUMP_VALUE(bool, kTypeHandleBool)
     }
 #undef DUMP_VALUE
   }
@@ -105,7 +114,7 @@ namespace sapphire::constant {
     return result;
   }
 
-  Object *GetConstantObject(string &id) {
+  Object *GetConstantObject(const string &id) {
     ObjectContainer &base = GetConstantBase();
     auto ptr = base.Find(id);
     return ptr;
@@ -170,6 +179,13 @@ namespace sapphire::runtime {
   static string binary_path;
   static string script_work_dir;
   static fs::path script_absolute_path;
+  static int optimization_level = 2;
+  static size_t call_depth_limit = kCallDepthLimitDefault;
+  static bool jit_enabled = false;
+  static size_t gc_threshold = kGcThresholdDefault;
+  static double gc_growth = kGcGrowthDefault;
+  static size_t gc_step_budget = kGcStepBudgetDefault;
+  static bool gc_stats_enabled = false;
 
   void InformBinaryPathAndName(string info) {
     fs::path processed_path(info);
@@ -212,4 +228,19 @@ namespace sapphire::runtime {
   string GetScriptAbsolutePath() {
     return script_absolute_path.string();
   }
+
+  void SetOptimizationLevel(int level) { optimization_level = level; }
+  int GetOptimizationLevel() { return optimization_level; }
+  void SetCallDepthLimit(size_t limit) { call_depth_limit = limit; }
+  size_t GetCallDepthLimit() { return call_depth_limit; }
+  void SetJitEnabled(bool enabled) { jit_enabled = enabled; }
+  bool IsJitEnabled() { return jit_enabled; }
+  void SetGcThreshold(size_t threshold) { gc_threshold = threshold; }
+  size_t GetGcThreshold() { return gc_threshold; }
+  void SetGcGrowth(double growth) { gc_growth = growth; }
+  double GetGcGrowth() { return gc_growth; }
+  void SetGcStepBudget(size_t budget) { gc_step_budget = budget; }
+  size_t GetGcStepBudget() { return gc_step_budget; }
+  void SetGcStatsEnabled(bool enabled) { gc_stats_enabled = enabled; }
+  bool IsGcStatsEnabled() { return gc_stats_enabled; }
 }
\ No newline at end of file
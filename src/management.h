@@ -30,14 +30,16 @@ namespace sapphire::components {
     size_t operator()(Object const &rhs) const {
       auto copy = rhs; //bypass
       size_t value = 0;
-      auto type_id = rhs.GetTypeId();
       
 #define GET_HASH(_Type) value = std::hash<_Type>()(copy.Cast<_Type>())
 
-      if (type_id == kTypeIdInt) GET_HASH(int64_t);
-      else if (type_id == kTypeIdFloat) GET_HASH(double);
-      else if (type_id == kTypeIdString) GET_HASH(string);
-      else if (type_id == kTypeIdBool) GET_HASH(bool);
+      switch (rhs.GetTypeHandle()) {
+      case kTypeHandleInt: GET_HASH(int64_t); break;
+      case kTypeHandleFloat: GET_HASH(double); break;
+      case kTypeHandleString: GET_HASH(string); break;
+      case kTypeHandleBool: GET_HASH(bool); break;
+      default: break;
+      }
 
       return value;
 #undef GET_HASH
@@ -49,13 +51,15 @@ namespace sapphire::components {
       //bypass
       auto copy_lhs = lhs, copy_rhs = rhs;
       bool result = false;
-      if (lhs.GetTypeId() != rhs.GetTypeId()) return result;
+      if (lhs.GetTypeHandle() != rhs.GetTypeHandle()) return result;
 #define COMPARE(_Type) (copy_lhs.Cast<_Type>() == copy_rhs.Cast<_Type>())
-      auto type_id = lhs.GetTypeId();
-      if (type_id == kTypeIdInt) result = COMPARE(int64_t);
-      else if (type_id == kTypeIdFloat) result = COMPARE(double);
-      else if (type_id == kTypeIdString) result = COMPARE(string);
-      else if (type_id == kTypeIdBool) result = COMPARE(bool);
+      switch (lhs.GetTypeHandle()) {
+      case kTypeHandleInt: result = COMPARE(int64_t); break;
+      case kTypeHandleFloat: result = COMPARE(double); break;
+      case kTypeHandleString: result = COMPARE(string); break;
+      case kTypeHandleBool: result = COMPARE(bool); break;
+      default: break;
+      }
       return result;
 #undef COMPARE
     }
@@ -65,7 +69,7 @@ namespace sapphire::components {
 namespace sapphire::constant {
   Object *CreateConstantObject(string id, Object &object);
   Object *CreateConstantObject(string id, Object &&object);
-  Object *GetConstantObject(string &id);
+  Object *GetConstantObject(const string &id);
 }
 
 namespace sapphire::script {
@@ -78,6 +82,14 @@ namespace sapphire::script {
 }
 
 namespace sapphire::runtime {
+  // Frames of script calling, including the main frame
+  const size_t kCallDepthLimitDefault = 10000;
+  // Tracked containers before first collection, 0 disables collector
+  const size_t kGcThresholdDefault = 10000;
+  const double kGcGrowthDefault = 2.0;
+  // Containers scanned in one step of collection, 0 for whole heap
+  const size_t kGcStepBudgetDefault = 1024;
+
   void InformBinaryPathAndName(string info);
   string GetBinaryPath();
   string GetBinaryName();
@@ -85,12 +97,28 @@ namespace sapphire::runtime {
   bool SetWorkingDirectory(string dir);
   void InformScriptPath(string path);
   string GetScriptAbsolutePath();
+  void SetOptimizationLevel(int level);
+  int GetOptimizationLevel();
+  void SetCallDepthLimit(size_t limit);
+  size_t GetCallDepthLimit();
+  void SetJitEnabled(bool enabled);
+  bool IsJitEnabled();
+  void SetGcThreshold(size_t threshold);
+  size_t GetGcThreshold();
+  void SetGcGrowth(double growth);
+  double GetGcGrowth();
+  void SetGcStepBudget(size_t budget);
+  size_t GetGcStepBudget();
+  void SetGcStatsEnabled(bool enabled);
+  bool IsGcStatsEnabled();
 }
 
 namespace sapphire {
   using ObjectTable = unordered_map<Object, Object, 
     components::PlainTypeHash, components::PlainTypeComparaion>;
   using ManagedTable = shared_ptr<ObjectTable>;
+  template <>
+  inline constexpr CollectableKind kCollectableKind<ObjectTable> = CollectableKind::Table;
 }
 
 #define EXPORT_CONSTANT(ID) constant::CreateConstantObject(#ID, Object(ID))
@@ -0,0 +1,119 @@
+#include "native.h"
+#include "argument.h"
+
+namespace sapphire {
+  using Processor = ArgumentProcessor<kHeadDoubleHorizon, kJoinerEqual>;
+
+  Annotation NativeAnnotation(unsigned flags, size_t nest, size_t nest_end,
+    size_t escape_depth, Operation nest_root) {
+    Annotation annotation;
+
+    annotation.void_call = (flags & kNativeVoidCall) != 0;
+    annotation.local_object = (flags & kNativeLocalObject) != 0;
+    annotation.ext_object = (flags & kNativeExtObject) != 0;
+    annotation.use_last_assert = (flags & kNativeUseLastAssert) != 0;
+    annotation.tail_call = (flags & kNativeTailCall) != 0;
+    annotation.nest = nest;
+    annotation.nest_end = nest_end;
+    annotation.escape_depth = escape_depth;
+    annotation.nest_root = nest_root;
+    return annotation;
+  }
+
+  // Token id is given by its source string, ids of running process may
+  // differ from the ones of translating process.
+  Argument NativeArgument(const char *data, ArgumentType type, LiteralType literal,
+    unsigned flags, const char *domain, ArgumentType domain_type, const char *token) {
+    Argument arg(data, type, literal);
+
+    arg.properties.fn.variable_param = (flags & kNativeVariableParam) != 0;
+    arg.properties.fn.constraint = (flags & kNativeConstraint) != 0;
+    arg.properties.member_access.use_last_assert = (flags & kNativeLastAssert) != 0;
+    arg.properties.member_access.is_chain_tail = (flags & kNativeChainTail) != 0;
+    arg.SetDomain(domain, domain_type);
+    if (token != nullptr) arg.properties.token_id = TryAppendTokenId(token);
+    return arg;
+  }
+
+  ASTNode NativeNode(Operation operation, size_t line, Annotation annotation) {
+    ASTNode node(operation);
+
+    node.idx = line;
+    node.annotation = annotation;
+    return node;
+  }
+
+  ASTNode NativeCall(const char *id, Argument domain, size_t line, Annotation annotation) {
+    ASTNode node(id, domain);
+
+    node.idx = line;
+    node.annotation = annotation;
+    return node;
+  }
+
+  // Binary is expected to stay next to translated source, see
+  // sapphire_add_native_script(). Absolute path is taken as it is.
+  string NativeScriptPath(const NativeScript &script) {
+    fs::path path(script.path);
+    if (path.is_absolute()) return path.string();
+    return (fs::path(runtime::GetBinaryPath()) / path).lexically_normal().string();
+  }
+
+  void RunNativeScript(const NativeScript &script, string log_path) {
+    AnnotatedAST &script_file = script::AppendBlankScript(NativeScriptPath(script));
+    auto table = make_shared<NativeBlockTable>();
+
+    script.build(script_file);
+
+    for (size_t idx = 0; idx < script.block_count; idx += 1) {
+      table->emplace(script.blocks[idx].base, script.blocks[idx].block);
+    }
+
+    Bytecode bytecode(script_file);
+    bytecode.AttachNativeBlocks(table);
+    AASTMachine main_thread(bytecode, log_path, true);
+    main_thread.Run();
+  }
+
+  int NativeScriptMain(const NativeScript &script, int argc, char **argv) {
+    Processor processor = {
+      Pattern("log"    , Option(true, true)),
+      Pattern("locale" , Option(true, true)),
+      Pattern("depth"  , Option(true, true))
+    };
+
+    runtime::InformBinaryPathAndName(argv[0]);
+    ActivateComponents();
+
+    if (argc > 1 && !processor.Generate(argc, argv)) {
+      puts(ArgumentProcessorError(processor.Error())
+        .Report(processor.BadArg()).data());
+      return 1;
+    }
+
+    string log = processor.Exist("log") ?
+      processor.ValueOf("log") :
+      "project-sapphire.log";
+
+    if (processor.Exist("depth")) {
+      string depth = processor.ValueOf("depth");
+      size_t limit = 0;
+      auto result = from_chars(depth.data(), depth.data() + depth.size(), limit);
+
+      if (result.ec != std::errc() || limit < 2) {
+        puts("Invalid call depth limit");
+        return 1;
+      }
+
+      runtime::SetCallDepthLimit(limit);
+    }
+
+    setlocale(LC_ALL, processor.Exist("locale") ?
+      processor.ValueOf("locale").data() : "en_US.UTF8");
+
+    runtime::InformScriptPath(NativeScriptPath(script));
+    RunNativeScript(script, log);
+    CloseStream();
+    return 0;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "machine.h"
+
+namespace sapphire {
+  // Support of scripts translated by --emit-cpp.
+  // Translated source rebuilds AnnotatedAST of the script without analysis
+  // and provides native blocks for it. Generated entry:
+  //   extern "C" int sapphire_native_main(int argc, char **argv);
+  // 'main' is also generated if SAPPHIRE_NATIVE_MAIN is defined.
+
+  enum NativeAnnotationFlag : unsigned {
+    kNativeVoidCall      = 1,
+    kNativeLocalObject   = 2,
+    kNativeExtObject     = 4,
+    kNativeUseLastAssert = 8,
+    kNativeTailCall      = 16
+  };
+
+  enum NativeArgumentFlag : unsigned {
+    kNativeVariableParam = 1,
+    kNativeConstraint    = 2,
+    kNativeLastAssert    = 4,
+    kNativeChainTail     = 8
+  };
+
+  struct NativeBlockEntry {
+    size_t base;
+    NativeBlock block;
+  };
+
+  // Path of script is relative to translated source, and it's resolved
+  // against directory of the binary at startup.
+  struct NativeScript {
+    const char *path;
+    void (*build)(AnnotatedAST &ast);
+    const NativeBlockEntry *blocks;
+    size_t block_count;
+  };
+
+  Annotation NativeAnnotation(unsigned flags, size_t nest, size_t nest_end,
+    size_t escape_depth, Operation nest_root);
+  Argument NativeArgument(const char *data, ArgumentType type, LiteralType literal,
+    unsigned flags = 0, const char *domain = "", ArgumentType domain_type = ArgumentType::Invalid,
+    const char *token = nullptr);
+  ASTNode NativeNode(Operation operation, size_t line, Annotation annotation);
+  ASTNode NativeCall(const char *id, Argument domain, size_t line, Annotation annotation);
+
+  string NativeScriptPath(const NativeScript &script);
+  void RunNativeScript(const NativeScript &script, string log_path);
+  int NativeScriptMain(const NativeScript &script, int argc, char **argv);
+}
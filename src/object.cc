@@ -6,6 +6,30 @@ namespace sapphire {
     return token_id_counter;
   }
 
+  size_t GetContainerSerial() {
+    static size_t serial = 0;
+    serial += 1;
+    return serial;
+  }
+
+  vector<size_t> &GetBindingVersionTable() {
+    static vector<size_t> table;
+    return table;
+  }
+
+  void UpdateBindingVersion(string_view id) {
+    UpdateBindingVersion(TryAppendTokenId(id));
+  }
+
+  vector<bool> &GetLocalBindingTable() {
+    static vector<bool> table;
+    return table;
+  }
+
+  void ResetBindingVersion() {
+    for (auto &unit : GetBindingVersionTable()) unit += 1;
+  }
+
   TokenIdMap &GetTokenIdMap() {
     static TokenIdMap base;
     return base;
@@ -28,6 +52,40 @@ namespace sapphire {
     return result;
   }
 
+  struct TypeRegistry {
+    unordered_map<string, TypeHandle> handles;
+    deque<string> names;
+
+    TypeRegistry() : handles(), names() {
+      //same order as kTypeHandle* constants
+      for (auto &unit : { string(), kTypeIdInt, kTypeIdFloat, kTypeIdString, kTypeIdBool,
+        kTypeIdNull, kTypeIdAnyStorage, kTypeIdWideString, kTypeIdArray, kTypeIdInStream,
+        kTypeIdOutStream, kTypeIdFunction, kTypeIdFunctionPointer, kTypeIdObjectPointer,
+        kTypeIdPair, kTypeIdTable, kTypeIdStruct, kTypeIdModule, kTypeIdExtension }) {
+        handles.try_emplace(unit, names.size());
+        names.push_back(unit);
+      }
+    }
+  };
+
+  static TypeRegistry &GetTypeRegistry() {
+    static TypeRegistry registry;
+    return registry;
+  }
+
+  TypeHandle TryAppendTypeHandle(string_view type_id) {
+    auto &registry = GetTypeRegistry();
+    auto emplace_result = registry.handles.try_emplace(string(type_id), registry.names.size());
+
+    if (emplace_result.second) registry.names.emplace_back(type_id);
+
+    return emplace_result.first->second;
+  }
+
+  const string &GetTypeName(TypeHandle handle) {
+    return GetTypeRegistry().names[handle];
+  }
+
   vector<string> BuildStringVector(string source) {
     vector<string> result;
     string temp;
@@ -62,11 +120,15 @@ namespace sapphire {
   }
 
   Object &Object::operator=(const Object &object) {
+    ObjectInfo last = info_;
     info_ = object.info_;
+    //holding new anchor first, in case of assigning to itself
+    HoldAnchor();
+    if (last.mode == ObjectMode::Ref) ReleaseRefAnchor(static_cast<RefAnchor *>(last.real_dest));
 
     if (info_.mode != ObjectMode::Ref) {
-      info_.real_dest = nullptr;
-      dynamic_cast<shared_ptr<void> *>(this)->operator=(object);
+      if (!info_.unboxed) info_.real_dest = nullptr;
+      Base() = object;
     }
     else {
       reset();
@@ -75,83 +137,132 @@ namespace sapphire {
     return *this;
   }
 
-  Object &Object::PackContent(shared_ptr<void> ptr, string type_id) {
+  Object &Object::PackContent(shared_ptr<void> ptr, TypeHandle type) {
     if (info_.mode == ObjectMode::Ref) {
-      return static_cast<ObjectPointer>(info_.real_dest)
-        ->PackContent(ptr, type_id);
+      return Target()->PackContent(ptr, type);
     }
 
-    dynamic_cast<shared_ptr<void> *>(this)->operator=(ptr);
-    info_.type_id = type_id;
+    Base() = ptr;
+    if (info_.unboxed) info_.real_dest = nullptr;
+    info_.type = static_cast<uint32_t>(type);
+    info_.unboxed = false;
     return *this;
   }
 
   Object &Object::swap(Object &obj) {
-    dynamic_cast<shared_ptr<void> *>(this)->swap(obj);
-    std::swap(info_.type_id, obj.info_.type_id);
-    std::swap(info_.mode, obj.info_.mode);
-    std::swap(info_.delivering, obj.info_.delivering);
-    std::swap(info_.real_dest, obj.info_.real_dest);
-    std::swap(info_.sub_container, obj.info_.sub_container);
-    std::swap(info_.alive, obj.info_.alive);
+    Base().swap(obj.Base());
+    std::swap(info_, obj.info_);
     return *this;
   }
 
   Object &Object::PackObject(Object &object) {
+    //ref of ref object shares anchor of final target
+    auto *anchor = object.IsRef() ? object.HeldAnchor() : object.GetAnchor();
+    anchor->refs += 1;
+    DropAnchor();
+
     reset();
-    info_.type_id = object.info_.type_id;
+    info_.type = object.info_.type;
     info_.mode = ObjectMode::Ref;
+    info_.unboxed = false;
+    info_.real_dest = anchor;
 
-    if (!object.IsRef()) {
-      info_.real_dest = &object;
-      info_.alive = true;
+    return *this;
+  }
+
+  // Anchors are allocated in pool and never freed. Pool is leaked on
+  // purpose, objects with static storage may still release anchors at exit.
+  static deque<RefAnchor> &GetRefAnchorPool() {
+    static auto *pool = new deque<RefAnchor>();
+    return *pool;
+  }
+
+  static RefAnchor *free_anchors = nullptr;
+
+  RefAnchor *CreateRefAnchor(ObjectPointer target) {
+    RefAnchor *anchor = free_anchors;
+
+    if (anchor != nullptr) {
+      free_anchors = anchor->next_free;
     }
     else {
-      info_.real_dest = object.info_.real_dest;
-      info_.alive = object.info_.alive;
+      anchor = &GetRefAnchorPool().emplace_back();
     }
 
-    if (object.IsAlive()) EstablishRefLink();
+    anchor->target = target;
+    anchor->refs = 0;
+    anchor->next_free = nullptr;
+    return anchor;
+  }
 
-    return *this;
+  void RecycleRefAnchor(RefAnchor *anchor) {
+    anchor->next_free = free_anchors;
+    free_anchors = anchor;
   }
 
-  bool ObjectContainer::Add(string id, Object &source, size_t token_id) {
-    if (IsDelegated()) return delegator_->Add(id, source, token_id);
+  ObjectPointer ObjectContainer::Emplace(const string &id, const Object &source, 
+    size_t token_id, bool update_version) {
+    if (IsDelegated()) return delegator_->Emplace(id, source, token_id, update_version);
+    if (shape_ != nullptr && (shape_->Lookup(id) != kNoMemberSlot ||
+      shape_->LookupMethod(id) != kNoMemberSlot)) return nullptr;
     auto result = container_.try_emplace(id, source);
-    if (result.second && token_id != 0) {
-      token_cache_[token_id] = &result.first->second;
-      token_cache_.rehash(token_cache_.size());
+    if (!result.second) return nullptr;
+    if (token_id != 0) token_cache_[token_id] = &result.first->second;
+    if (token_id != 0 && prev_ != nullptr) MarkLocalBinding(token_id);
+    if (update_version) {
+      token_id != 0 ? UpdateBindingVersion(token_id) : UpdateBindingVersion(id);
     }
 
-    return result.second;
+    return &result.first->second;
   }
 
-  bool ObjectContainer::Add(string id, Object &&source, size_t token_id) {
-    if (IsDelegated()) return delegator_->Add(id, std::move(source), token_id);
-    auto result = container_.try_emplace(id, source);
-    if (result.second && token_id != 0) {
-      token_cache_[token_id] = &result.first->second;
-    }
+  bool ObjectContainer::Add(string id, Object &source, size_t token_id) {
+    return Emplace(id, source, token_id) != nullptr;
+  }
 
-    return result.second;
+  bool ObjectContainer::Add(string id, Object &&source, size_t token_id) {
+    return Emplace(id, source, token_id) != nullptr;
   }
 
   void ObjectContainer::Replace(string id, Object &source, size_t token_id) {
     if (IsDelegated()) delegator_->Replace(id, source, token_id);
 
-    container_[id] = source;
+    if (shape_ != nullptr) {
+      if (auto idx = shape_->Lookup(id); idx != kNoMemberSlot) {
+        slots_[idx] = source;
+        return;
+      }
+    }
+
+    auto result = container_.try_emplace(id);
+    result.first->second = source;
+    if (result.second) {
+      token_id != 0 ? UpdateBindingVersion(token_id) : UpdateBindingVersion(id);
+      if (token_id != 0 && prev_ != nullptr) MarkLocalBinding(token_id);
+    }
     if (token_id != 0) {
-      token_cache_[token_id] = &container_[id];
+      token_cache_[token_id] = &result.first->second;
     }
   }
 
   void ObjectContainer::Replace(string id, Object &&source, size_t token_id) {
     if (IsDelegated()) delegator_->Replace(id, std::move(source), token_id);
 
-    container_[id] = source;
+    if (shape_ != nullptr) {
+      if (auto idx = shape_->Lookup(id); idx != kNoMemberSlot) {
+        slots_[idx] = source;
+        return;
+      }
+    }
+
+    auto result = container_.try_emplace(id);
+    result.first->second = source;
+    if (result.second) {
+      token_id != 0 ? UpdateBindingVersion(token_id) : UpdateBindingVersion(id);
+      if (token_id != 0 && prev_ != nullptr) MarkLocalBinding(token_id);
+    }
     if (token_id != 0) {
-      token_cache_[token_id] = &container_[id];
+      token_cache_[token_id] = &result.first->second;
     }
   }
 
@@ -159,11 +270,19 @@ namespace sapphire {
     if (IsDelegated()) return delegator_->Find(id, forward_seeking);
     ObjectPointer ptr = nullptr;
 
+    if (shape_ != nullptr) {
+      if (auto idx = shape_->Lookup(id); idx != kNoMemberSlot) return &slots_[idx];
+    }
+
     auto it = container_.find(id);
 
     if (it != container_.end()) {
       ptr = &it->second;
     }
+    else if (auto idx = shape_ != nullptr ? shape_->LookupMethod(id) : kNoMemberSlot; 
+      idx != kNoMemberSlot) {
+      ptr = &shape_->GetMethod(idx);
+    }
     else if (prev_ != nullptr && forward_seeking) {
       ptr = prev_->Find(id, forward_seeking);
     }
@@ -187,6 +306,62 @@ namespace sapphire {
     return ptr;
   }
 
+  // Guarded slot load. Cache is refilled whenever the container has another
+  // shape than last time. Method can be shadowed by member outside of shape,
+  // method table is used directly only if there's no such member.
+  Object *ObjectContainer::FindMember(const string &id, MemberSlotCache &cache) {
+    if (IsDelegated()) return delegator_->FindMember(id, cache);
+
+    if (shape_ != nullptr) {
+      if (cache.shape == shape_->GetSerial()) {
+        if (!cache.method) return &slots_[cache.index];
+        if (container_.empty()) return &shape_->GetMethod(cache.index);
+      }
+
+      if (auto idx = shape_->Lookup(id); idx != kNoMemberSlot) {
+        cache.shape = shape_->GetSerial();
+        cache.index = idx;
+        cache.method = false;
+        return &slots_[idx];
+      }
+
+      if (auto idx = shape_->LookupMethod(id); idx != kNoMemberSlot && container_.empty()) {
+        cache.shape = shape_->GetSerial();
+        cache.index = idx;
+        cache.method = true;
+        return &shape_->GetMethod(idx);
+      }
+    }
+
+    return Find(id, false);
+  }
+
+  // Moving members named in shape from hash table into slots, methods of
+  // shape are dropped from hash table
+  void ObjectContainer::ApplyShape(ShapeHandle shape) {
+    if (IsDelegated()) {
+      delegator_->ApplyShape(shape);
+      return;
+    }
+
+    slots_.clear();
+    slots_.resize(shape->size());
+
+    for (size_t idx = 0; idx < shape->size(); idx += 1) {
+      auto it = container_.find(shape->GetName(idx));
+      if (it == container_.end()) continue;
+      slots_[idx] = it->second;
+      container_.erase(it);
+    }
+
+    for (size_t idx = 0; idx < shape->CountMethods(); idx += 1) {
+      container_.erase(shape->GetMethodName(idx));
+    }
+
+    token_cache_.clear();
+    shape_ = shape;
+  }
+
   Object *ObjectContainer::FindWithDomain(const string &id, 
     const string &domain, bool forward_seeking) {
     if (IsDelegated()) return delegator_->FindWithDomain(id, domain, forward_seeking);
@@ -220,9 +395,23 @@ namespace sapphire {
     for (const auto &unit : container_) {
       if (&unit.second == ptr) result = true;
     }
+    for (const auto &unit : slots_) {
+      if (&unit == ptr) result = true;
+    }
     return result;
   }
 
+  void ObjectContainer::Erase(const string &id, size_t token_id) {
+    if (IsDelegated()) {
+      delegator_->Erase(id, token_id);
+      return;
+    }
+
+    if (container_.erase(id) == 0) return;
+    if (token_id != 0) token_cache_.erase(token_id);
+    token_id != 0 ? UpdateBindingVersion(token_id) : UpdateBindingVersion(id);
+  }
+
   void ObjectContainer::ClearExcept(string exceptions) {
     if (IsDelegated()) delegator_->ClearExcept(exceptions);
     using Iterator = unordered_map<string, Object>::iterator;
@@ -235,6 +424,13 @@ namespace sapphire {
       if (!find_in_vector(it->first, obj_list)) {
         ready_to_del = it;
         ++it;
+        for (auto cache_it = token_cache_.begin(); cache_it != token_cache_.end(); ++cache_it) {
+          if (cache_it->second == &ready_to_del->second) {
+            token_cache_.erase(cache_it);
+            break;
+          }
+        }
+        UpdateBindingVersion(ready_to_del->first);
         container_.erase(ready_to_del);
         continue;
       }
@@ -268,6 +464,23 @@ namespace sapphire {
     }
   }
 
+  void CallArguments::Naturalize(ObjectContainer &container) {
+    for (auto &unit : *this) {
+      if (unit.IsRef() && container.IsInside(unit.GetRealDest())) {
+        unit = unit.Unpack();
+      }
+    }
+  }
+
+  void CallArguments::ExportTo(vector<string> &params, ObjectMap &dest) {
+    size_t pos = params.size();
+
+    for (auto &unit : *this) {
+      pos -= 1;
+      dest.emplace(params[pos], unit);
+    }
+  }
+
   void ObjectStack::MergeMap(ObjectMap &p) {
     if (p.empty()) return;
 
@@ -309,7 +522,7 @@ namespace sapphire {
     return ptr;
   }
 
-  bool ObjectStack::CreateObject(string id, Object &obj, size_t token_id) {
+  ObjectPointer ObjectStack::CreateObject(string id, Object &obj, size_t token_id) {
     if (!creation_info_.empty() && !creation_info_.top().first) {
       ScopeCreation(creation_info_.top().second);
       creation_info_.top().first = true;
@@ -317,16 +530,16 @@ namespace sapphire {
 
     if (base_.empty()) {
       if (prev_ == nullptr) {
-        return false;
+        return nullptr;
       }
       return prev_->CreateObject(id, obj, token_id);
     }
     auto &top = base_.back();
 
-    return top.Add(id, obj, token_id);
+    return top.Emplace(id, obj, token_id);
   }
 
-  bool ObjectStack::CreateObject(string id, Object &&obj, size_t token_id) {
+  ObjectPointer ObjectStack::CreateObject(string id, Object &&obj, size_t token_id) {
     if (!creation_info_.empty() && !creation_info_.top().first) {
       ScopeCreation(creation_info_.top().second);
       creation_info_.top().first = true;
@@ -334,12 +547,12 @@ namespace sapphire {
 
     if (base_.empty()) {
       if (prev_ == nullptr) {
-        return false;
+        return nullptr;
       }
       return prev_->CreateObject(id, std::move(obj), token_id);
     }
     auto &top = base_.back();
     
-    return top.Add(id, std::move(obj), token_id);
+    return top.Emplace(id, obj, token_id);
   }
 }
\ No newline at end of file
@@ -13,18 +13,80 @@ namespace sapphire {
 
   TokenIdMap &GetTokenIdMap();
   size_t TryAppendTokenId(string_view id);
+  size_t GetContainerSerial();
+
+  // Binding version of identifier is increased whenever the identifier may be
+  // resolved to another object. Cached lookup results are valid only within
+  // the same version and the same innermost scope.
+  vector<size_t> &GetBindingVersionTable();
+  void UpdateBindingVersion(string_view id);
+  void ResetBindingVersion();
+
+  inline size_t GetBindingVersion(size_t token_id) {
+    auto &table = GetBindingVersionTable();
+    if (token_id >= table.size()) table.resize(token_id + 1, 1);
+    return table[token_id];
+  }
+
+  inline void UpdateBindingVersion(size_t token_id) {
+    auto &table = GetBindingVersionTable();
+    if (token_id >= table.size()) table.resize(token_id + 1, 1);
+    table[token_id] += 1;
+  }
+
+  // Identifiers ever bound in a scope other than global scope. Struct
+  // bound in global scope can be cached for every scope only if its name
+  // is not one of them, as it may be shadowed by such binding.
+  vector<bool> &GetLocalBindingTable();
+
+  inline void MarkLocalBinding(size_t token_id) {
+    auto &table = GetLocalBindingTable();
+    if (token_id >= table.size()) table.resize(token_id + 1, false);
+    table[token_id] = true;
+  }
+
+  inline bool HasLocalBinding(size_t token_id) {
+    auto &table = GetLocalBindingTable();
+    return token_id < table.size() && table[token_id];
+  }
   // It is unnecessary.
   // size_t TryGetTokenId(string_view id);
 
-  struct _ObjectCommonBase {
-    virtual bool IsObjectView() const = 0;
-    virtual bool IsAlive() const = 0;
-    virtual ~_ObjectCommonBase() {}
-  };
+  // Interned type id.
+  // Built-in types have fixed handles, and plain types share the same values
+  // with PlainType, so type dispatch is a plain integer comparison. The name
+  // string is only for reflection and error messages.
+  using TypeHandle = size_t;
+
+  const TypeHandle kTypeHandleInvalid         = 0;
+  const TypeHandle kTypeHandleInt             = 1;
+  const TypeHandle kTypeHandleFloat           = 2;
+  const TypeHandle kTypeHandleString          = 3;
+  const TypeHandle kTypeHandleBool            = 4;
+  const TypeHandle kTypeHandleNull            = 5;
+  const TypeHandle kTypeHandleAnyStorage      = 6;
+  const TypeHandle kTypeHandleWideString      = 7;
+  const TypeHandle kTypeHandleArray           = 8;
+  const TypeHandle kTypeHandleInStream        = 9;
+  const TypeHandle kTypeHandleOutStream       = 10;
+  const TypeHandle kTypeHandleFunction        = 11;
+  const TypeHandle kTypeHandleFunctionPointer = 12;
+  const TypeHandle kTypeHandleObjectPointer   = 13;
+  const TypeHandle kTypeHandlePair            = 14;
+  const TypeHandle kTypeHandleTable           = 15;
+  const TypeHandle kTypeHandleStruct          = 16;
+  const TypeHandle kTypeHandleModule          = 17;
+  const TypeHandle kTypeHandleExtension       = 18;
+
+  TypeHandle TryAppendTypeHandle(string_view type_id);
+  const string &GetTypeName(TypeHandle handle);
+
+  inline bool IsPlainTypeHandle(TypeHandle handle) {
+    return handle >= kTypeHandleInt && handle <= kTypeHandleBool;
+  }
 
   using GenericPointer = uintptr_t;
   using ObjectPointer = Object *;
-  using ObjectCommonSlot = _ObjectCommonBase *;
   using ObjectRef = Object &;
   using NamedObject = pair<string, Object>;
   using ContainerPool = list<ObjectContainer>;
@@ -34,7 +96,7 @@ namespace sapphire {
   vector<string> BuildStringVector(string source);
   string CombineStringVector(vector<string> target);
 
-  enum class ObjectMode {
+  enum class ObjectMode : uint8_t {
     Invalid   = 0,
     Normal    = 1,
     Ref       = 2,
@@ -57,126 +119,220 @@ namespace sapphire {
       ptr_(ptr), disposer_(disposer), type_id_(type_id) {}
   };
 
+  // Storage of unboxed plain scalar.
+  // int, float and bool values are kept inside Object directly, so producing
+  // temporary result of these types doesn't touch the allocator.
+  union ScalarValue {
+    int64_t int_value;
+    double float_value;
+    bool bool_value;
+  };
+
+  // Header of object, two machine words.
+  // Unboxed scalar shares storage with real_dest, which is only used by
+  // Ref object (RefAnchor of target) and External object.
   struct ObjectInfo {
-    void *real_dest;
+    union {
+      void *real_dest;
+      ScalarValue scalar;
+    };
+    uint32_t type;
     ObjectMode mode;
-    bool delivering;
-    bool sub_container;
-    bool alive;
-    string type_id;
+    bool delivering : 1;
+    bool sub_container : 1;
+    bool unboxed : 1;
+
+    ObjectInfo(void *real_dest, ObjectMode mode, bool delivering, bool sub_container,
+      TypeHandle type, bool unboxed) :
+      real_dest(real_dest), type(static_cast<uint32_t>(type)), mode(mode), 
+      delivering(delivering), sub_container(sub_container), unboxed(unboxed) {}
   };
 
-  // No use in this time...
-  struct ViewCounter {
-    bool dead;
-    std::atomic_int32_t count;
+  // Indirection handle between ref objects and their target.
+  // Target object owns one anchor since it's referenced for the first time,
+  // every ref object holds a count on it. Anchor is left behind when target
+  // is destroyed, so dead target is detected by null target pointer, and
+  // goes back to pool after the last ref object is dropped.
+  struct RefAnchor {
+    ObjectPointer target;
+    size_t refs;
+    RefAnchor *next_free;
   };
 
-  using ReferenceLinks = unordered_set<ObjectPointer>;
+  RefAnchor *CreateRefAnchor(ObjectPointer target);
+  void RecycleRefAnchor(RefAnchor *anchor);
+
+  inline void ReleaseRefAnchor(RefAnchor *anchor) {
+    anchor->refs -= 1;
+    if (anchor->refs == 0 && anchor->target == nullptr) RecycleRefAnchor(anchor);
+  }
+
+  template <typename T>
+  constexpr bool kUnboxedType = 
+    std::is_same_v<T, int64_t> || std::is_same_v<T, double> || std::is_same_v<T, bool>;
+
+  // Heap containers which can hold each other and form reference cycles.
+  // Containers are registered to cycle collector on creation, kind of
+  // container type is specialized next to its definition. See collector.h
+  enum class CollectableKind { None, Struct, Array, Table, Function };
 
-  class Object : public shared_ptr<void>, virtual public _ObjectCommonBase {
+  template <typename T>
+  inline constexpr CollectableKind kCollectableKind = CollectableKind::None;
+
+  void TrackCollectable(const shared_ptr<void> &ptr, CollectableKind kind);
+
+  // Reference counted object.
+  // No virtual base and no lock inside, every array element, table entry
+  // and scope slot pays for the size of this class.
+  class Object : public shared_ptr<void> {
   private:
     ObjectInfo info_;
-    ViewCounter *counter_;
-    optional<ReferenceLinks> links_;
-    mutex gate_;
+    // Anchor of this object as target, created on first reference
+    RefAnchor *anchor_;
 
   private:
-    void EraseRefLink() {
-      if (info_.mode == ObjectMode::Ref && info_.alive) {
-        auto *obj = static_cast<ObjectPointer>(info_.real_dest);
-        obj->links_.value().erase(this);
-      }
+    shared_ptr<void> &Base() { return *this; }
+
+    // Anchor of target, ref object only
+    RefAnchor *HeldAnchor() const { return static_cast<RefAnchor *>(info_.real_dest); }
+    ObjectPointer Target() const { return HeldAnchor()->target; }
+
+    void HoldAnchor() {
+      if (info_.mode == ObjectMode::Ref) HeldAnchor()->refs += 1;
     }
 
-    void EstablishRefLink() {
-      if (info_.mode == ObjectMode::Ref && info_.alive) {
-        auto *obj = static_cast<ObjectPointer>(info_.real_dest);
-        if(!obj->links_.has_value()) obj->links_.emplace(ReferenceLinks());
-        obj->links_.value().insert(this);
-      }
+    void DropAnchor() {
+      if (info_.mode == ObjectMode::Ref) ReleaseRefAnchor(HeldAnchor());
+    }
+
+    RefAnchor *GetAnchor() {
+      if (anchor_ == nullptr) anchor_ = CreateRefAnchor(this);
+      return anchor_;
+    }
+
+    template <typename T>
+    T &Scalar() {
+      if constexpr (std::is_same_v<T, int64_t>) return info_.scalar.int_value;
+      else if constexpr (std::is_same_v<T, double>) return info_.scalar.float_value;
+      else return info_.scalar.bool_value;
+    }
+
+    template <typename T>
+    void StoreScalar(T value) {
+      info_.unboxed = true;
+      Scalar<T>() = value;
     }
 
   public:
     ~Object() {
-      EraseRefLink();
-
-      if (info_.mode != ObjectMode::Ref && links_.has_value() && !links_.value().empty()) {
-        for (auto &unit : links_.value()) {
-          if (unit != nullptr) {
-            unit->info_.alive = false;
-            unit->info_.real_dest = nullptr;
-          }
-        }
+      DropAnchor();
+
+      if (anchor_ != nullptr) {
+        anchor_->target = nullptr;
+        if (anchor_->refs == 0) RecycleRefAnchor(anchor_);
       }
     }
 
-    Object() : info_{ nullptr, ObjectMode::Normal, false, false, true, kTypeIdNull},
-      links_(), shared_ptr<void>(nullptr) {}
+    Object() : info_{ nullptr, ObjectMode::Normal, false, false, kTypeHandleNull, false},
+      anchor_(nullptr), shared_ptr<void>(nullptr) {}
 
     Object(const Object &obj) : 
-      info_(obj.info_), links_(std::nullopt), shared_ptr<void>(obj) {
-      EstablishRefLink();
+      shared_ptr<void>(obj), info_(obj.info_), anchor_(nullptr) {
+      HoldAnchor();
     }
 
     Object(const Object &&obj) noexcept :
-      info_(std::move(obj.info_)), links_(std::nullopt), shared_ptr<void>(std::move(obj)) {
-      EstablishRefLink();
+      shared_ptr<void>(std::move(obj)), info_(obj.info_), anchor_(nullptr) {
+      HoldAnchor();
+    }
+
+    template <typename T>
+    Object(shared_ptr<T> ptr, TypeHandle type) :
+      info_{nullptr, ObjectMode::Normal, false, type == kTypeHandleStruct, type, false},
+      anchor_(nullptr), shared_ptr<void>(ptr) {
+      if constexpr (kCollectableKind<T> != CollectableKind::None) {
+        TrackCollectable(Base(), kCollectableKind<T>);
+      }
     }
 
     template <typename T>
     Object(shared_ptr<T> ptr, string type_id) :
-      info_{nullptr, ObjectMode::Normal, false, type_id == kTypeIdStruct, true, type_id},
-      links_(), shared_ptr<void>(ptr) {}
+      Object(ptr, TryAppendTypeHandle(type_id)) {}
 
     template <typename T>
     Object(T &t, string type_id) :
-      info_{nullptr, ObjectMode::Normal, false, type_id == kTypeIdStruct, true, type_id},
-      links_(), 
-      shared_ptr<void>(make_shared<T>(t)) {}
+      Object(t, TryAppendTypeHandle(type_id)) {}
 
     template <typename T>
     Object(T &&t, string type_id) :
-      info_{ nullptr, ObjectMode::Normal, false, type_id == kTypeIdStruct, true, type_id },
-      links_(),
-      shared_ptr<void>(make_shared<T>(std::forward<T>(t))) {}
+      Object(std::forward<T>(t), TryAppendTypeHandle(type_id)) {}
+
+    template <typename T>
+    Object(T &t, TypeHandle type) :
+      info_{nullptr, ObjectMode::Normal, false, type == kTypeHandleStruct, type, false},
+      anchor_(nullptr), shared_ptr<void>(nullptr) {
+      using Tx = std::remove_cv_t<T>;
+      if constexpr (kUnboxedType<Tx>) StoreScalar<Tx>(t);
+      else shared_ptr<void>::operator=(make_shared<Tx>(t));
+      if constexpr (kCollectableKind<Tx> != CollectableKind::None) {
+        TrackCollectable(Base(), kCollectableKind<Tx>);
+      }
+    }
+
+    template <typename T>
+    Object(T &&t, TypeHandle type) :
+      info_{ nullptr, ObjectMode::Normal, false, type == kTypeHandleStruct, type, false},
+      anchor_(nullptr), shared_ptr<void>(nullptr) {
+      using Tx = std::remove_cv_t<std::remove_reference_t<T>>;
+      if constexpr (kUnboxedType<Tx>) StoreScalar<Tx>(t);
+      else shared_ptr<void>::operator=(make_shared<Tx>(std::forward<T>(t)));
+      if constexpr (kCollectableKind<Tx> != CollectableKind::None) {
+        TrackCollectable(Base(), kCollectableKind<Tx>);
+      }
+    }
 
     Object(void *ext_ptr, ExternalMemoryDisposer disposer, string type_id) :
-      info_{ext_ptr, ObjectMode::External, false, false, true, type_id}, links_(std::nullopt),
+      info_{ext_ptr, ObjectMode::External, false, false, TryAppendTypeHandle(type_id), false}, 
+      anchor_(nullptr),
       shared_ptr<void>(make_shared<ExternalRCContainer>(ext_ptr, disposer, type_id)) {}
 
     Object(string str) :
-      info_{nullptr, ObjectMode::Normal, false, false, true, kTypeIdString},
-      links_(), shared_ptr<void>(make_shared<string>(str)) {}
+      info_{nullptr, ObjectMode::Normal, false, false, kTypeHandleString, false},
+      anchor_(nullptr), shared_ptr<void>(make_shared<string>(str)) {}
 
+    // Header must be taken from a living object
     Object(const ObjectInfo &info, const shared_ptr<void> &ptr) :
-      info_(info), links_(std::nullopt), shared_ptr<void>(ptr) {
-      EstablishRefLink();
+      info_(info), anchor_(nullptr), shared_ptr<void>(ptr) {
+      HoldAnchor();
     }
 
     Object &operator=(const Object &object);
-    Object &PackContent(shared_ptr<void> ptr, string type_id);
+    Object &PackContent(shared_ptr<void> ptr, TypeHandle type);
+    Object &PackContent(shared_ptr<void> ptr, string type_id) {
+      return PackContent(ptr, TryAppendTypeHandle(type_id));
+    }
     Object &swap(Object &obj);
     Object &PackObject(Object &object);
 
-    bool IsObjectView() const override { return false; }
-
     void Impact(ObjectInfo &&info, shared_ptr<void> ptr) {
+      ObjectInfo last = info_;
       info_ = info;
-      dynamic_cast<shared_ptr<void> *>(this)->operator=(ptr);
+      HoldAnchor();
+      if (last.mode == ObjectMode::Ref) ReleaseRefAnchor(static_cast<RefAnchor *>(last.real_dest));
+      Base() = ptr;
     }
 
     shared_ptr<void> Get() {
       if (info_.mode == ObjectMode::Ref) {
-        return static_cast<ObjectPointer>(info_.real_dest)->Get();
+        return Target()->Get();
       }
       
-      return *dynamic_cast<shared_ptr<void> *>(this);
+      return Base();
     }
 
     Object &Unpack() {
       if (info_.mode == ObjectMode::Ref) {
-        return *static_cast<ObjectPointer>(info_.real_dest);
+        return *Target();
       }
       return *this;
     }
@@ -184,7 +340,11 @@ namespace sapphire {
     template <typename Tx>
     Tx &Cast() {
       if (info_.mode == ObjectMode::Ref) { 
-        return static_cast<ObjectPointer>(info_.real_dest)->Cast<Tx>(); 
+        return Target()->Cast<Tx>(); 
+      }
+
+      if constexpr (kUnboxedType<Tx>) {
+        if (info_.unboxed) return Scalar<Tx>();
       }
 
       return *static_cast<Tx *>(get());
@@ -202,8 +362,7 @@ namespace sapphire {
 
     bool GetDeliveringFlag() {
       if (info_.mode == ObjectMode::Ref) {
-        return static_cast<ObjectPointer>(info_.real_dest)
-          ->GetDeliveringFlag();
+        return Target()->GetDeliveringFlag();
       }
       bool result = info_.delivering;
       info_.delivering = false;
@@ -212,15 +371,14 @@ namespace sapphire {
 
     bool SeekDeliveringFlag() {
       if (info_.mode == ObjectMode::Ref) {
-        return static_cast<ObjectPointer>(info_.real_dest)
-          ->SeekDeliveringFlag();
+        return Target()->SeekDeliveringFlag();
       }
       return info_.delivering;
     }
 
     bool IsSubContainer() {
       if (info_.mode == ObjectMode::Ref) {
-        return static_cast<ObjectPointer>(info_.real_dest)->IsSubContainer();
+        return Target()->IsSubContainer();
       }
 
       return info_.sub_container;
@@ -229,18 +387,26 @@ namespace sapphire {
     bool operator==(const Object &obj) = delete;
     bool operator==(const Object &&obj) = delete;
 
-    mutex &GetMutex() { return gate_; }
-    Object *GetRealDest() { return static_cast<ObjectPointer>(info_.real_dest); }
+    Object *GetRealDest() { 
+      return info_.mode == ObjectMode::Ref ? Target() : static_cast<ObjectPointer>(info_.real_dest); 
+    }
     ObjectInfo &GetObjectInfoTable() { return info_; }
     void *GetExternalPointer() { return info_.real_dest; }
     Object &operator=(const Object &&object) { return operator=(object); }
     Object &swap(Object &&obj) { return swap(obj); }
-    string GetTypeId() const { return info_.type_id; }
+    const string &GetTypeId() const { return GetTypeName(info_.type); }
+    TypeHandle GetTypeHandle() const { return info_.type; }
     bool IsRef() const { return info_.mode == ObjectMode::Ref; }
-    bool NullPtr() const { return !this->operator bool() && info_.real_dest == nullptr; }
+    bool NullPtr() const { 
+      if (info_.mode == ObjectMode::Ref) return Target() == nullptr;
+      return !this->operator bool() && info_.real_dest == nullptr && !info_.unboxed; 
+    }
+    bool IsUnboxed() const { return info_.unboxed; }
     ObjectMode GetMode() const { return info_.mode; }
     void SetContainerFlag() { info_.sub_container = true; }
-    bool IsAlive() const override { return info_.alive; }
+    bool IsAlive() const { return info_.mode != ObjectMode::Ref || Target() != nullptr; }
+    // Some ref object is pointing to this object
+    bool IsReferenced() const { return anchor_ != nullptr && anchor_->refs != 0; }
   };
 
   using MovableObject = unique_ptr<Object>;
@@ -251,7 +417,7 @@ namespace sapphire {
     Null
   };
 
-  class ObjectView : virtual public _ObjectCommonBase {
+  class ObjectView {
   protected:
     using Value = ObjectPointer;
     using Source = ObjectViewSource;
@@ -271,20 +437,87 @@ namespace sapphire {
 
     void operator=(const ObjectView &rhs) { value_ = rhs.value_; }
 
-    bool IsObjectView() const override { return true; }
     void operator=(const ObjectView &&rhs) { operator=(rhs); }
     Object &Seek() { return *value_; }
-    bool IsAlive() const override { return value_->IsAlive(); }
+    bool IsAlive() const { return value_->IsAlive(); }
     bool IsValid() const { return value_ != nullptr; }
     Object Dump() { return Seek(); }
   };
 
   using ObjectArray = deque<Object>;
+  template <>
+  inline constexpr CollectableKind kCollectableKind<ObjectArray> = CollectableKind::Array;
   using ManagedArray = shared_ptr<ObjectArray>;
   using ObjectPair = pair<Object, Object>;
   using ManagedPair = shared_ptr<ObjectPair>;
   using ObjectCache = pair<string, ObjectPointer>;
 
+  const size_t kNoMemberSlot = std::numeric_limits<size_t>::max();
+
+  // Member layout of struct, shared by struct definition and all of its
+  // instances. Members are stored in slot array of container by index.
+  // Methods are kept in the shape itself as method table of struct, it's
+  // built once at the end of struct definition and never changes later.
+  class StructShape {
+  private:
+    vector<string> names_;
+    unordered_map<string, size_t> index_;
+    vector<string> method_names_;
+    unordered_map<string, size_t> method_index_;
+    vector<Object> methods_;
+    size_t serial_;
+
+  public:
+    StructShape() : names_(), index_(), method_names_(), method_index_(), 
+      methods_(), serial_(GetContainerSerial()) {}
+
+    size_t Append(const string &name) {
+      auto result = index_.try_emplace(name, names_.size());
+      if (result.second) names_.push_back(name);
+      return result.first->second;
+    }
+
+    size_t Lookup(const string &name) const {
+      auto it = index_.find(name);
+      return it != index_.end() ? it->second : kNoMemberSlot;
+    }
+
+    // Inherited and included methods share function object with origin
+    void AppendMethod(const string &name, Object &method) {
+      auto result = method_index_.try_emplace(name, methods_.size());
+      if (result.second) {
+        method_names_.push_back(name);
+        methods_.push_back(method);
+      }
+      else {
+        methods_[result.first->second] = method;
+      }
+    }
+
+    size_t LookupMethod(const string &name) const {
+      auto it = method_index_.find(name);
+      return it != method_index_.end() ? it->second : kNoMemberSlot;
+    }
+
+    const string &GetName(size_t idx) const { return names_[idx]; }
+    const string &GetMethodName(size_t idx) const { return method_names_[idx]; }
+    Object &GetMethod(size_t idx) { return methods_[idx]; }
+    size_t size() const { return names_.size(); }
+    size_t CountMethods() const { return methods_.size(); }
+    size_t GetSerial() const { return serial_; }
+  };
+
+  using ShapeHandle = shared_ptr<StructShape>;
+
+  // Shape serial and slot (or method table) index of last resolved member
+  struct MemberSlotCache {
+    size_t shape;
+    size_t index;
+    bool method;
+
+    MemberSlotCache() : shape(0), index(0), method(false) {}
+  };
+
   class ObjectContainer {
   private:
     //struct 
@@ -299,11 +532,19 @@ namespace sapphire {
     ObjectContainer *prev_;
     unordered_map<string, Object> container_;
     CacheContainer token_cache_;
+    size_t serial_;
+    // Shaped container (struct and instance) keeps members of shape in
+    // slots_, other members are in container_. Slot array is never resized
+    // so pointers to members are stable. Shaped container is not a scope.
+    ShapeHandle shape_;
+    vector<Object> slots_;
 
     bool IsDelegated() const { 
       return delegator_ != nullptr; 
     }
   public:
+    ObjectPointer Emplace(const string &id, const Object &source, size_t token_id = 0,
+      bool update_version = true);
     bool Add(string id, Object &source, size_t token_id = 0);
     bool Add(string id, Object &&source, size_t token_id = 0);
     void Replace(string id, Object &source, size_t token_id = 0);
@@ -312,40 +553,110 @@ namespace sapphire {
     Object *FindByTokenId(size_t token_id, bool forward_seeking = true);
     Object *FindWithDomain(const string &id, const string &domain, bool forward_seeking = true);
     Object *FindWithDomainByTokenId(size_t token_id, const string &id, bool forward_seeking = true);
+    Object *FindMember(const string &id, MemberSlotCache &cache);
     bool IsInside(Object *ptr);
+    void Erase(const string &id, size_t token_id = 0);
     void ClearExcept(string exceptions);
+    void ApplyShape(ShapeHandle shape);
 
     ObjectContainer() : delegator_(nullptr),
-      prev_(nullptr), container_() {
+      prev_(nullptr), container_(), serial_(GetContainerSerial()), shape_(), slots_() {
+      token_cache_.max_load_factor(1);
+    }
+
+    // Empty instance of shape, every slot holds null object
+    explicit ObjectContainer(ShapeHandle shape) : delegator_(nullptr),
+      prev_(nullptr), container_(), serial_(GetContainerSerial()), 
+      shape_(shape), slots_(shape->size()) {
       token_cache_.max_load_factor(1);
     }
 
     ObjectContainer(const ObjectContainer &&mgr) :
-    delegator_(mgr.delegator_), prev_(mgr.prev_) {
+    delegator_(mgr.delegator_), prev_(mgr.prev_), serial_(GetContainerSerial()),
+    shape_(), slots_() {
       token_cache_.max_load_factor(1);
     }
 
     ObjectContainer(const ObjectContainer &container) :
       delegator_(container.delegator_), prev_(container.prev_),
-      container_() {
+      container_(), serial_(GetContainerSerial()), 
+      shape_(container.shape_), slots_(container.slots_) {
       if (!container.Empty()) container_ = container.container_;
       token_cache_.max_load_factor(1);
     }
 
     bool Empty() const {
-      return container_.empty();
+      return container_.empty() && slots_.empty();
     }
 
     void Clear() {
       if (IsDelegated()) delegator_->Clear();
+      if (shape_ != nullptr) {
+        for (size_t idx = 0; idx < shape_->size(); idx += 1) {
+          UpdateBindingVersion(shape_->GetName(idx));
+        }
+        shape_.reset();
+        slots_.clear();
+      }
+      if (container_.empty()) return;
+      for (auto &unit : container_) UpdateBindingVersion(unit.first);
       container_.clear();
+      token_cache_.clear();
     }
 
+    //unique in process lifetime, unlike address of container
+    size_t GetSerial() const { return serial_; }
+
+    // Reusing current scope for next calling (tail call), cached slots
+    // of last calling are dropped along with its objects.
+    void Renew() {
+      Clear();
+      serial_ = GetContainerSerial();
+    }
+
+    // Prepare popped scope for reusing.
+    // Same as destroying it, binding versions are left untouched and
+    // a new serial tells cached slots that this is another scope.
+    void Recycle() {
+      container_.clear();
+      token_cache_.clear();
+      shape_.reset();
+      slots_.clear();
+      delegator_ = nullptr;
+      prev_ = nullptr;
+      serial_ = GetContainerSerial();
+    }
+
+    // Members outside of shape only, use ForEach() to visit all members
     unordered_map<string, Object> &GetContent() {
       if (IsDelegated()) return delegator_->GetContent();
       return container_;
     }
 
+    template <typename Visitor>
+    void ForEach(Visitor visitor) {
+      if (IsDelegated()) {
+        delegator_->ForEach(visitor);
+        return;
+      }
+
+      for (size_t idx = 0; idx < slots_.size(); idx += 1) {
+        visitor(shape_->GetName(idx), slots_[idx]);
+      }
+
+      if (shape_ != nullptr) {
+        for (size_t idx = 0; idx < shape_->CountMethods(); idx += 1) {
+          visitor(shape_->GetMethodName(idx), shape_->GetMethod(idx));
+        }
+      }
+
+      for (auto &unit : container_) visitor(unit.first, unit.second);
+    }
+
+    const ShapeHandle &GetShape() const { return shape_; }
+    size_t CountSlots() const { return slots_.size(); }
+    Object &GetSlot(size_t idx) { return slots_[idx]; }
+
     ObjectContainer &SetPreviousContainer(ObjectContainer *prev) {
       if (IsDelegated()) return delegator_->SetPreviousContainer(prev);
       prev_ = prev;
@@ -359,6 +670,8 @@ namespace sapphire {
   };
 
   using ObjectStruct = ObjectContainer;
+  template <>
+  inline constexpr CollectableKind kCollectableKind<ObjectStruct> = CollectableKind::Struct;
 
   class ObjectMap : public unordered_map<string, Object> {
   public:
@@ -419,9 +732,19 @@ namespace sapphire {
     }
   };
 
+  // Arguments of user-defined function, stored in reversed parameter order
+  // as they are fetched from operands.
+  class CallArguments : public vector<Object> {
+  public:
+    void Naturalize(ObjectContainer &container);
+    void ExportTo(vector<string> &params, ObjectMap &dest);
+  };
+
   // first - created, second - inherit_last_scope
   using CreationInfo = pair<bool, bool>;
 
+  const size_t kScopePoolSize = 64;
+
   class ObjectStack {
   private:
     using DataType = list<ObjectContainer>;
@@ -432,6 +755,8 @@ namespace sapphire {
     stack<CreationInfo, list<CreationInfo>> creation_info_;
     // One-time trigger for avoiding confliction of global scope creation
     bool delegated_;
+    // Popped scopes, nodes are spliced back on next creation
+    DataType spare_;
 
   private:
     void ScopeCreation(bool inherit_last_scope) {
@@ -439,7 +764,8 @@ namespace sapphire {
       auto *prev = base_.empty() ? nullptr : &base_.back();
       // global(base) scope
       auto *base_scope = base_.empty() ? nullptr : &base_.front();
-      base_.emplace_back(ObjectContainer());
+      if (spare_.empty()) base_.emplace_back(ObjectContainer());
+      else base_.splice(base_.end(), spare_, std::prev(spare_.end()));
       // link previous container
       base_.back().SetPreviousContainer(inherit_last_scope ? prev : base_scope);
     }
@@ -454,19 +780,22 @@ namespace sapphire {
       root_container_(nullptr),
       base_(),
       prev_(nullptr),
-      delegated_(false) {}
+      delegated_(false),
+      spare_() {}
 
     ObjectStack(const ObjectStack &rhs) :
       root_container_(rhs.root_container_),
       base_(rhs.base_),
       prev_(rhs.prev_),
-      delegated_(false) {}
+      delegated_(false),
+      spare_() {}
 
     ObjectStack(const ObjectStack &&rhs) :
       ObjectStack(rhs) {}
 
     ObjectStack &SetPreviousStack(ObjectStack &prev) {
       prev_ = &prev;
+      ResetBindingVersion();
       return *this;
     }
 
@@ -478,6 +807,11 @@ namespace sapphire {
       return *this;
     }
 
+    // Identity of scope chain that Find() is working on
+    size_t GetScopeSerial() {
+      return base_.empty() ? 0 : base_.back().GetSerial();
+    }
+
     ObjectContainer &GetCurrent() { 
       if (HasDelayedCreation()) ScopeCreation(creation_info_.top().second);
       return base_.back(); 
@@ -491,6 +825,14 @@ namespace sapphire {
       return true;
     }
 
+    bool RenewCurrent() {
+      if (!HasDelayedCreation()) {
+        if (base_.empty()) return false;
+        base_.back().Renew();
+      }
+      return true;
+    }
+
     bool ClearCurrentExcept(string exceptions) {
       if (!HasDelayedCreation()) {
         if (base_.empty()) return false;
@@ -523,7 +865,13 @@ namespace sapphire {
 
     ObjectStack &Pop() {
       if (!HasDelayedCreation()) {
-        base_.pop_back();
+        if (spare_.size() < kScopePoolSize) {
+          base_.back().Recycle();
+          spare_.splice(spare_.end(), base_, std::prev(base_.end()));
+        }
+        else {
+          base_.pop_back();
+        }
       }
       if(!creation_info_.empty()) creation_info_.pop();
       return *this;
@@ -535,9 +883,32 @@ namespace sapphire {
     }
 
     void MergeMap(ObjectMap &p);
+
+    // Arguments are bound in newly created (or renewed) scope. No lookup
+    // result can refer to this scope yet, so binding versions are kept and
+    // slots of other callings stay valid. Receiver gets position of
+    // parameter and bound object.
+    template <typename Receiver>
+    void BindArguments(vector<string> &params, vector<size_t> &tokens, CallArguments &args,
+      Receiver receiver) {
+      auto &container = base_.back();
+      size_t pos = params.size();
+
+      for (auto &unit : args) {
+        pos -= 1;
+        auto *ptr = container.Emplace(
+          params[pos],
+          (unit.IsRef() ? Object().PackObject(unit) : unit),
+          tokens[pos],
+          false
+        );
+        if (ptr != nullptr) receiver(pos, ptr);
+      }
+    }
+
     Object *Find(const string &id, size_t token_id = 0);
     Object *Find(const string &id, const string &domain, size_t token_id = 0);
-    bool CreateObject(string id, Object &obj, size_t token_id = 0);
-    bool CreateObject(string id, Object &&obj, size_t token_id = 0);
+    ObjectPointer CreateObject(string id, Object &obj, size_t token_id = 0);
+    ObjectPointer CreateObject(string id, Object &&obj, size_t token_id = 0);
   };
 }
@@ -0,0 +1,582 @@
+#include <cmath>
+#include "optimizer.h"
+
+namespace sapphire {
+  bool IsBlockRoot(Operation operation) {
+    return compare(operation, Operation::If, Operation::While, Operation::Fn, Operation::Case,
+      Operation::Struct, Operation::Module, Operation::For);
+  }
+
+  bool IsPureOperator(Operation operation) {
+    return compare(operation, Operation::Plus, Operation::Minus, Operation::Times,
+      Operation::Divide, Operation::Equals, Operation::LessOrEqual, Operation::GreaterOrEqual,
+      Operation::NotEqual, Operation::Greater, Operation::Less, Operation::And, Operation::Or,
+      Operation::Not);
+  }
+
+  // Inlined body is a straight line of pure operators ending with return.
+  // It has no side effect, no calling and no jump, and leaves exactly the
+  // returned value on return stack. Every name in the body must be one of
+  // its parameters, any other name would be resolved in caller's scope
+  // after expanding.
+  bool ASTOptimizer::IsInlineBody(size_t begin, size_t end, const vector<string> &params) {
+    auto is_param = [&params](const string &id) -> bool {
+      return find(params.begin(), params.end(), id) != params.end();
+    };
+    stack<size_t> record;
+    size_t depth = 0;
+
+    if (end <= begin || end - begin > kInlineBodyMax) return false;
+
+    for (size_t idx = begin; idx < end; idx += 1) {
+      auto &node = ast_[idx].first;
+      auto &args = ast_[idx].second;
+      size_t pops = 0;
+
+      if (node.type != NodeType::Operation) return false;
+      if (node.annotation.nest_end != 0 || ast_.FindJumpRecord(idx, record)) return false;
+
+      for (auto &unit : args) {
+        if (unit.properties.member_access.use_last_assert) return false;
+        if (unit.HasDomain() && unit.properties.domain.type != ArgumentType::Pool) return false;
+        if (unit.HasDomain() && !is_param(unit.properties.domain.id)) return false;
+        if (!unit.HasDomain() && unit.GetType() == ArgumentType::Pool && !is_param(unit.GetData())) return false;
+        if (unit.GetType() == ArgumentType::RetStack) pops += 1;
+      }
+
+      if (pops > depth) return false;
+      depth -= pops;
+
+      if (idx + 1 == end) {
+        return node.GetOperation() == Operation::Return && args.size() == 1 && depth == 0;
+      }
+
+      if (!IsPureOperator(node.GetOperation()) || node.annotation.void_call) return false;
+      depth += 1;
+    }
+
+    return false;
+  }
+
+  // Function defined once at top level, and its name is used nowhere else.
+  // Call sites after the definition always reach this function.
+  bool ASTOptimizer::CollectInlineCandidates(unordered_map<string, InlineCandidate> &dest) {
+    unordered_map<string, size_t> references;
+    size_t depth = 0;
+
+    for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+      auto &node = ast_[idx].first;
+      auto &args = ast_[idx].second;
+      auto operation = node.GetOperation();
+
+      //names may be brought in by other scripts
+      if (compare(operation, Operation::Include, Operation::Using)) return false;
+
+      for (auto &unit : args) {
+        references[unit.GetData()] += 1;
+        if (unit.HasDomain()) references[unit.properties.domain.id] += 1;
+      }
+
+      if (node.HasDomain()) references[node.GetFunctionDomain().GetData()] += 1;
+
+      if (operation == Operation::Fn && depth == 0 && node.annotation.void_call &&
+        !args.empty() && node.annotation.nest_end > idx) {
+        InlineCandidate candidate{ idx + 1, node.annotation.nest_end, {} };
+        bool good = true;
+
+        for (size_t pos = 1; pos < args.size(); pos += 1) {
+          auto &properties = args[pos].properties;
+          if (properties.fn.variable_param || properties.fn.constraint) good = false;
+          candidate.params.push_back(args[pos].GetData());
+        }
+
+        if (good) dest.emplace(args[0].GetData(), candidate);
+      }
+
+      if (IsBlockRoot(operation)) depth += 1;
+      else if (operation == Operation::End && depth > 0) depth -= 1;
+    }
+
+    for (auto it = dest.begin(); it != dest.end();) {
+      if (references[it->first] != 1 || !IsInlineBody(it->second.begin, it->second.end, it->second.params)) {
+        it = dest.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+
+    return true;
+  }
+
+  bool ASTOptimizer::IsInlineCallSite(size_t idx, InlineCandidate &callee) {
+    auto &node = ast_[idx].first;
+    auto &args = ast_[idx].second;
+
+    if (node.HasDomain() || idx < callee.end || args.size() != callee.params.size()) return false;
+
+    for (size_t pos = 0; pos < args.size(); pos += 1) {
+      auto &arg = args[pos];
+
+      if (arg.properties.member_access.use_last_assert || arg.HasDomain()) return false;
+
+      if (arg.GetType() == ArgumentType::Literal) {
+        if (!compare(arg.GetStringType(), LiteralType::Int, LiteralType::Float,
+          LiteralType::Bool, LiteralType::String)) return false;
+
+        //literal can't be domain of member access
+        for (size_t body_idx = callee.begin; body_idx < callee.end; body_idx += 1) {
+          for (auto &unit : ast_[body_idx].second) {
+            if (unit.HasDomain() && unit.properties.domain.id == callee.params[pos]) return false;
+          }
+        }
+      }
+      else if (arg.GetType() != ArgumentType::Pool && arg.GetType() != ArgumentType::RetStack) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Literal and named arguments are substituted into the body, as the body
+  // can't rebind them. Named arguments are looked up once at calling line
+  // as GenerateArgs2() does, so missing object is reported at that line.
+  // Values on return stack are bound to names unique to this call site,
+  // and these names are dropped by Unbind after the returning value.
+  // Body nodes keep their own lines for error messages.
+  void ASTOptimizer::ExpandCall(size_t idx, InlineCandidate &callee, size_t serial, AnnotatedAST &dest) {
+    auto &call = ast_[idx].first;
+    auto &args = ast_[idx].second;
+    string prefix = "__inline" + to_string(serial) + "_";
+    unordered_map<string, Argument> substitution;
+    ArgumentList bound;
+
+    for (size_t pos = args.size(); pos > 0; pos -= 1) {
+      auto &param = callee.params[pos - 1];
+      auto &arg = args[pos - 1];
+
+      if (arg.GetType() == ArgumentType::Literal) {
+        substitution[param] = arg;
+        continue;
+      }
+
+      if (arg.GetType() == ArgumentType::Pool) {
+        ASTNode check(Operation::ExpList);
+        check.idx = call.idx;
+        check.annotation.void_call = true;
+        dest.emplace_back(Sentense(check, ArgumentList{ arg }));
+        substitution[param] = arg;
+        continue;
+      }
+
+      Argument target(prefix + param, ArgumentType::Literal, LiteralType::Identifier);
+      Argument local(prefix + param, ArgumentType::Pool, LiteralType::Identifier);
+      ASTNode bind(Operation::Bind);
+
+      target.properties.token_id = TryAppendTokenId(target.GetData());
+      local.properties.token_id = target.properties.token_id;
+      bind.idx = call.idx;
+      bind.annotation.void_call = true;
+      dest.emplace_back(Sentense(bind, ArgumentList{ target, arg }));
+      substitution[param] = local;
+      bound.push_back(target);
+    }
+
+    for (size_t body_idx = callee.begin; body_idx < callee.end; body_idx += 1) {
+      auto node = ast_[body_idx].first;
+      auto body_args = ast_[body_idx].second;
+
+      for (auto &unit : body_args) {
+        if (unit.GetType() != ArgumentType::Pool) continue;
+
+        if (!unit.HasDomain()) {
+          auto it = substitution.find(unit.GetData());
+          if (it != substitution.end()) unit = it->second;
+        }
+        else if (auto it = substitution.find(unit.properties.domain.id); it != substitution.end()) {
+          unit.properties.domain.id = it->second.GetData();
+          unit.properties.token_id = TryAppendTokenId(unit.properties.domain.id);
+        }
+      }
+
+      node.annotation.tail_call = false;
+
+      if (body_idx + 1 < callee.end) {
+        dest.emplace_back(Sentense(node, body_args));
+        continue;
+      }
+
+      //returning value is left on return stack, or pushed by ExpList
+      if (body_args[0].GetType() == ArgumentType::RetStack) {
+        dest.back().first.annotation.void_call = call.annotation.void_call;
+      }
+      else {
+        ASTNode value(Operation::ExpList);
+        value.idx = node.idx;
+        value.annotation.void_call = call.annotation.void_call;
+        dest.emplace_back(Sentense(value, body_args));
+      }
+    }
+
+    if (!bound.empty()) {
+      ASTNode unbind(Operation::Unbind);
+      unbind.idx = call.idx;
+      unbind.annotation.void_call = true;
+      dest.emplace_back(Sentense(unbind, bound));
+    }
+  }
+
+  // Inlining small top level functions, see IsInlineBody(). Call sites in
+  // struct and module body are skipped as binding works differently there.
+  void ASTOptimizer::InlineCalls() {
+    unordered_map<string, InlineCandidate> candidates;
+    AnnotatedAST result;
+    vector<size_t> index_map(ast_.size() + 1, 0);
+    vector<bool> from_source;
+    stack<Operation> blocks;
+    size_t struct_depth = 0;
+    size_t serial = 0;
+
+    if (!CollectInlineCandidates(candidates) || candidates.empty()) return;
+
+    for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+      auto &node = ast_[idx].first;
+      auto operation = node.GetOperation();
+      auto it = node.type == NodeType::Function ?
+        candidates.find(node.GetFunctionId()) : candidates.end();
+
+      index_map[idx] = result.size();
+
+      if (it != candidates.end() && struct_depth == 0 && IsInlineCallSite(idx, it->second)) {
+        ExpandCall(idx, it->second, serial, result);
+        from_source.resize(result.size(), false);
+        serial += 1;
+      }
+      else {
+        result.push_back(ast_[idx]);
+        from_source.push_back(true);
+      }
+
+      if (IsBlockRoot(operation)) {
+        blocks.push(operation);
+        if (compare(operation, Operation::Struct, Operation::Module)) struct_depth += 1;
+      }
+      else if (operation == Operation::End && !blocks.empty()) {
+        if (compare(blocks.top(), Operation::Struct, Operation::Module)) struct_depth -= 1;
+        blocks.pop();
+      }
+    }
+
+    if (serial == 0) return;
+
+    index_map[ast_.size()] = result.size();
+
+    for (size_t idx = 0; idx < result.size(); idx += 1) {
+      if (!from_source[idx]) continue;
+
+      auto &annotation = result[idx].first.annotation;
+
+      if (result[idx].first.GetOperation() == Operation::End) annotation.nest = index_map[annotation.nest];
+      if (annotation.nest_end != 0) annotation.nest_end = index_map[annotation.nest_end];
+    }
+
+    ast_.swap(result);
+    ast_.RebaseJumpRecords(index_map);
+  }
+
+  // Index of next node which is not removed yet
+  size_t ASTOptimizer::NextNode(size_t idx) {
+    do { idx += 1; } while (idx < ast_.size() && removed_[idx]);
+    return idx;
+  }
+
+  bool ASTOptimizer::MakeConstant(Argument &arg, Object &dest) {
+    if (arg.GetType() != ArgumentType::Literal) return false;
+    if (!compare(arg.GetStringType(), LiteralType::Int, LiteralType::Float,
+      LiteralType::Bool, LiteralType::String)) return false;
+
+    return MaterializeLiteral(arg, dest);
+  }
+
+  // Converting folded value back into literal argument.
+  // Values without exact literal form are not folded.
+  bool ASTOptimizer::MakeLiteral(Object &obj, Argument &dest) {
+    string data;
+    LiteralType type = LiteralType::Invalid;
+
+    switch (obj.GetTypeHandle()) {
+    case kTypeHandleInt:
+      data = to_string(obj.Cast<int64_t>());
+      type = LiteralType::Int;
+      break;
+    case kTypeHandleFloat: {
+      auto value = obj.Cast<double>();
+      char buffer[32];
+
+      if (!std::isfinite(value)) return false;
+
+      snprintf(buffer, sizeof(buffer), "%.17g", value);
+      data = buffer;
+      //keep it apart from integer literal in constant table
+      if (data.find_first_of(".e") == string::npos) data.append(".0");
+      type = LiteralType::Float;
+      break;
+    }
+    case kTypeHandleBool:
+      data = obj.Cast<bool>() ? kStrTrue : kStrFalse;
+      type = LiteralType::Bool;
+      break;
+    case kTypeHandleString:
+      for (auto unit : obj.Cast<string>()) {
+        if (unit == '\\' || unit == '\'' || static_cast<unsigned char>(unit) < 0x20) return false;
+      }
+
+      data = "'" + obj.Cast<string>() + "'";
+      type = LiteralType::String;
+      break;
+    default:
+      return false;
+    }
+
+    dest = Argument(data, ArgumentType::Literal, type);
+    return true;
+  }
+
+  bool ASTOptimizer::Evaluate(Operation operation, Object &lhs, Object &rhs, Object &dest) {
+    //integer division by zero is left to runtime
+    if (operation == Operation::Divide &&
+      GetResultType(FindTypeCode(lhs.GetTypeHandle()), FindTypeCode(rhs.GetTypeHandle())) == PlainType::Int &&
+      IntProducer(rhs) == 0) {
+      return false;
+    }
+
+    switch (operation) {
+    case Operation::Plus: dest = PlainMathOperation<Operation::Plus>(lhs, rhs); break;
+    case Operation::Minus: dest = PlainMathOperation<Operation::Minus>(lhs, rhs); break;
+    case Operation::Times: dest = PlainMathOperation<Operation::Times>(lhs, rhs); break;
+    case Operation::Divide: dest = PlainMathOperation<Operation::Divide>(lhs, rhs); break;
+    case Operation::Equals: dest = PlainLogicOperation<Operation::Equals>(lhs, rhs); break;
+    case Operation::LessOrEqual: dest = PlainLogicOperation<Operation::LessOrEqual>(lhs, rhs); break;
+    case Operation::GreaterOrEqual: dest = PlainLogicOperation<Operation::GreaterOrEqual>(lhs, rhs); break;
+    case Operation::NotEqual: dest = PlainLogicOperation<Operation::NotEqual>(lhs, rhs); break;
+    case Operation::Greater: dest = PlainLogicOperation<Operation::Greater>(lhs, rhs); break;
+    case Operation::Less: dest = PlainLogicOperation<Operation::Less>(lhs, rhs); break;
+    case Operation::And: dest = PlainLogicOperation<Operation::And>(lhs, rhs); break;
+    case Operation::Or: dest = PlainLogicOperation<Operation::Or>(lhs, rhs); break;
+    default: return false;
+    }
+
+    return IsPlainTypeHandle(dest.GetTypeHandle());
+  }
+
+  // Operator with two literal operands is replaced by its result.
+  // The result is written into operand of next node which takes it from
+  // return stack, and the operator node is removed.
+  bool ASTOptimizer::FoldConstant(size_t idx) {
+    auto &node = ast_[idx].first;
+    auto &args = ast_[idx].second;
+    Object lhs, rhs, result;
+    Argument literal;
+
+    if (node.type != NodeType::Operation || node.annotation.void_call || args.size() != 2) return false;
+    if (!MakeConstant(args[0], lhs) || !MakeConstant(args[1], rhs)) return false;
+    if (!Evaluate(node.GetOperation(), lhs, rhs, result)) return false;
+    if (!MakeLiteral(result, literal)) return false;
+
+    auto next_idx = NextNode(idx);
+    if (next_idx >= ast_.size() || jump_targets_.count(next_idx) != 0) return false;
+
+    auto &next = ast_[next_idx].first;
+    auto &next_args = ast_[next_idx].second;
+    auto operation = next.GetOperation();
+
+    if (next.idx != node.idx) return false;
+
+    auto pops_stack = [](Argument &arg) -> bool {
+      return arg.GetType() == ArgumentType::RetStack ||
+        (arg.GetType() == ArgumentType::Pool && arg.properties.domain.type == ArgumentType::RetStack);
+    };
+
+    size_t stack_operands = 0;
+    Argument *target = nullptr;
+    size_t target_pos = 0;
+
+    for (size_t pos = 0; pos < next_args.size(); pos += 1) {
+      if (!pops_stack(next_args[pos])) continue;
+      stack_operands += 1;
+      target = &next_args[pos];
+      target_pos = pos;
+    }
+
+    if (next.type == NodeType::Function && next.GetFunctionDomain().GetType() == ArgumentType::RetStack) {
+      return false;
+    }
+
+    if (target == nullptr || target->GetType() != ArgumentType::RetStack) return false;
+
+    // Binary operators fetch right hand side first, so the last operand
+    // is on top of return stack. Other nodes must take only one value.
+    if (next.type == NodeType::Operation) {
+      bool binary = compare(operation, Operation::Plus, Operation::Minus, Operation::Times,
+        Operation::Divide, Operation::Equals, Operation::LessOrEqual, Operation::GreaterOrEqual,
+        Operation::NotEqual, Operation::Greater, Operation::Less, Operation::And, Operation::Or);
+      bool single = compare(operation, Operation::Return, Operation::If, Operation::Elif,
+        Operation::While, Operation::Case, Operation::When, Operation::Print, Operation::PrintLine,
+        Operation::ExpList, Operation::InitialArray, Operation::Assert, Operation::Not,
+        Operation::ShortCircuit) ||
+        (operation == Operation::Bind && target_pos == 1);
+
+      if (!binary && !(single && stack_operands == 1)) return false;
+    }
+    else if (stack_operands != 1) {
+      return false;
+    }
+
+    *target = literal;
+    removed_[idx] = true;
+    return true;
+  }
+
+  // Pure operator with discarded result
+  bool ASTOptimizer::IsDeadResult(size_t idx) {
+    auto &node = ast_[idx].first;
+    auto &args = ast_[idx].second;
+    Object dummy;
+
+    if (node.type != NodeType::Operation || !node.annotation.void_call) return false;
+
+    bool pure = compare(node.GetOperation(), Operation::Plus, Operation::Minus, Operation::Times,
+      Operation::Divide, Operation::Equals, Operation::LessOrEqual, Operation::GreaterOrEqual,
+      Operation::NotEqual, Operation::Greater, Operation::Less, Operation::And, Operation::Or,
+      Operation::ExpList);
+
+    if (!pure || args.empty()) return false;
+
+    for (auto &unit : args) {
+      if (!MakeConstant(unit, dummy)) return false;
+    }
+
+    //same as folding, keep error of integer division by zero
+    if (node.GetOperation() == Operation::Divide && args.size() == 2) {
+      Object lhs, rhs, result;
+      MakeConstant(args[0], lhs);
+      MakeConstant(args[1], rhs);
+      if (!Evaluate(Operation::Divide, lhs, rhs, result)) return false;
+    }
+
+    return true;
+  }
+
+  void ASTOptimizer::CollectJumpTargets() {
+    stack<size_t> record;
+
+    jump_targets_.clear();
+
+    for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+      auto &annotation = ast_[idx].first.annotation;
+
+      if (ast_[idx].first.GetOperation() == Operation::End) jump_targets_.insert(annotation.nest);
+      if (annotation.nest_end != 0) jump_targets_.insert(annotation.nest_end);
+
+      if (ast_.FindJumpRecord(idx, record)) {
+        while (!record.empty()) {
+          jump_targets_.insert(record.top());
+          record.pop();
+        }
+      }
+    }
+  }
+
+  void ASTOptimizer::Compact() {
+    vector<size_t> index_map(ast_.size() + 1, 0);
+    size_t count = 0;
+
+    for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+      index_map[idx] = count;
+      if (!removed_[idx]) count += 1;
+    }
+
+    index_map[ast_.size()] = count;
+
+    if (count == ast_.size()) return;
+
+    size_t dest = 0;
+
+    for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+      if (removed_[idx]) continue;
+
+      auto &annotation = ast_[idx].first.annotation;
+
+      if (ast_[idx].first.GetOperation() == Operation::End) annotation.nest = index_map[annotation.nest];
+      if (annotation.nest_end != 0) annotation.nest_end = index_map[annotation.nest_end];
+      if (dest != idx) ast_[dest] = std::move(ast_[idx]);
+      dest += 1;
+    }
+
+    ast_.resize(count);
+    ast_.RebaseJumpRecords(index_map);
+    removed_.assign(count, false);
+  }
+
+  // Function body is sliced out as [nest + 1, nest_end). Calling node is a
+  // tail call if it's the last node of body, or only followed by returning
+  // its own result.
+  void ASTOptimizer::AnnotateTailCall() {
+    for (auto &unit : ast_) unit.first.annotation.tail_call = false;
+
+    for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+      if (ast_[idx].first.GetOperation() != Operation::Fn) continue;
+
+      size_t body_begin = idx + 1;
+      size_t body_end = ast_[idx].first.annotation.nest_end;
+
+      if (body_end <= body_begin) continue;
+
+      ast_[body_end - 1].first.annotation.tail_call = true;
+
+      if (body_end - 1 > body_begin) {
+        auto &current = ast_[body_end - 2];
+        auto &next = ast_[body_end - 1];
+        bool needed_by_next_call =
+          next.first.GetOperation() == Operation::Return &&
+          next.second.size() == 1 &&
+          next.second.back().GetType() == ArgumentType::RetStack;
+
+        if (!current.first.annotation.void_call && needed_by_next_call) {
+          current.first.annotation.tail_call = true;
+        }
+      }
+    }
+  }
+
+  void ASTOptimizer::Start() {
+    if (level_ >= 2) InlineCalls();
+
+    removed_.assign(ast_.size(), false);
+
+    if (level_ >= 1) {
+      bool changed = true;
+
+      CollectJumpTargets();
+
+      while (changed) {
+        changed = false;
+
+        for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+          if (removed_[idx]) continue;
+          if (FoldConstant(idx)) changed = true;
+        }
+      }
+    }
+
+    if (level_ >= 2) {
+      for (size_t idx = 0; idx < ast_.size(); idx += 1) {
+        if (!removed_[idx] && IsDeadResult(idx)) removed_[idx] = true;
+      }
+    }
+
+    Compact();
+    AnnotateTailCall();
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "machine.h"
+
+namespace sapphire {
+  // Optimization levels
+  //   0 - annotation only
+  //   1 - constant folding
+  //   2 - constant folding, dead result elimination and inlining
+  const int kOptimizationLevelMax = 2;
+
+  // Largest function body to be inlined, in nodes
+  const size_t kInlineBodyMax = 8;
+
+  // Top level function which can be inlined at its call sites
+  struct InlineCandidate {
+    size_t begin, end;
+    vector<string> params;
+  };
+
+  // Optimizing pass over AnnotatedAST, runs before building bytecode.
+  // Nodes are marked first and compacted at the end, every jump target
+  // (nest, nest_end, branch records) is rebased to the remaining nodes.
+  class ASTOptimizer {
+  protected:
+    AnnotatedAST &ast_;
+    int level_;
+    vector<bool> removed_;
+    unordered_set<size_t> jump_targets_;
+
+    bool IsInlineBody(size_t begin, size_t end, const vector<string> &params);
+    bool CollectInlineCandidates(unordered_map<string, InlineCandidate> &dest);
+    bool IsInlineCallSite(size_t idx, InlineCandidate &callee);
+    void ExpandCall(size_t idx, InlineCandidate &callee, size_t serial, AnnotatedAST &dest);
+    void InlineCalls();
+    size_t NextNode(size_t idx);
+    bool MakeConstant(Argument &arg, Object &dest);
+    bool MakeLiteral(Object &obj, Argument &dest);
+    bool Evaluate(Operation operation, Object &lhs, Object &rhs, Object &dest);
+    bool FoldConstant(size_t idx);
+    bool IsDeadResult(size_t idx);
+    void CollectJumpTargets();
+    void Compact();
+    void AnnotateTailCall();
+
+  public:
+    ASTOptimizer() = delete;
+    ASTOptimizer(AnnotatedAST &ast, int level) :
+      ast_(ast), level_(level), removed_(), jump_targets_() {}
+
+    void Start();
+  };
+}
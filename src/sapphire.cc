@@ -1,4 +1,8 @@
 #include "machine.h"
+#include "optimizer.h"
+#include "emitter.h"
+#include "jit.h"
+#include "collector.h"
 #include "argument.h"
 
 namespace fs = std::filesystem;
@@ -15,9 +19,30 @@ void BootMainVMObject(string path, string log_path, bool real_time_log) {
     GrammarAndSemanticAnalysis analysis(path, script_file, log_path, real_time_log);
     if (!analysis.Start()) return;
   }
+
+  ASTOptimizer(script_file, runtime::GetOptimizationLevel()).Start();
   
-  AASTMachine main_thread(script_file, log_path, real_time_log);
+  Bytecode bytecode(script_file);
+  AASTMachine main_thread(bytecode, log_path, real_time_log);
   main_thread.Run();
+
+  if (runtime::IsGcStatsEnabled()) PrintCollectorStats();
+}
+
+void EmitNativeScript(string path, string log_path, string dest) {
+  string absolute_path = fs::absolute(fs::path(path)).string();
+  AnnotatedAST &script_file = script::AppendBlankScript(absolute_path);
+
+  {
+    GrammarAndSemanticAnalysis analysis(path, script_file, log_path, true);
+    if (!analysis.Start()) return;
+  }
+
+  ASTOptimizer(script_file, runtime::GetOptimizationLevel()).Start();
+
+  if (!CppEmitter(script_file, absolute_path).Start(dest)) {
+    printf("Cannot write translated script: %s\n", dest.data());
+  }
 }
 
 void ApplicationInfo() {
@@ -37,6 +62,14 @@ void HelpFile() {
     "\tlocale=LOCALE_STR   Locale string for interpreter.(default=en_US.UTF8)\n"
     "\tvm_stdout=FILE      Redirection of script standard output.\n"
     "\tvm_stdin=FILE       Redirection of script standard input.\n"
+    "\topt=LEVEL           Optimization level, 0-2.(default=2)\n"
+    "\tdepth=N             Maximum depth of function calling.(default=10000)\n"
+    "\temit-cpp=FILE       Translate script into C++ source instead of running it.\n"
+    "\tjit                 Compile hot code blocks into machine code.(Linux x86-64)\n"
+    "\tgc-threshold=N      Containers allocated before first cycle collection, 0 to disable.(default=10000)\n"
+    "\tgc-growth=F         Heap growth factor to start next collection.(default=2.0)\n"
+    "\tgc-step=N           Containers scanned in one collection step, 0 for whole heap.(default=1024)\n"
+    "\tgc-stats            Print statistics of cycle collector at exit.\n"
     "\twait                Automatically pause at application exit.\n"
     "\thelp                Show this message.\n"
     "\tversion             Show version message of interpreter.\n"
@@ -82,11 +115,94 @@ void Processing(Processor &processor) {
       GetVMStdin(fopen(vm_stdin.data(), "r"));
     }
 
+    if (processor.Exist("opt")) {
+      string opt = processor.ValueOf("opt");
+      int level = -1;
+      from_chars(opt.data(), opt.data() + opt.size(), level);
+
+      if (level < 0 || level > kOptimizationLevelMax) {
+        puts("Invalid optimization level");
+        return;
+      }
+
+      runtime::SetOptimizationLevel(level);
+    }
+
+    if (processor.Exist("depth")) {
+      string depth = processor.ValueOf("depth");
+      size_t limit = 0;
+      auto result = from_chars(depth.data(), depth.data() + depth.size(), limit);
+
+      if (result.ec != std::errc() || limit < 2) {
+        puts("Invalid call depth limit");
+        return;
+      }
+
+      runtime::SetCallDepthLimit(limit);
+    }
+
+    if (processor.Exist("jit")) {
+      if (!IsJitSupported()) {
+        puts("JIT is not supported on this platform");
+        return;
+      }
+
+      runtime::SetJitEnabled(true);
+    }
+
+    if (processor.Exist("gc-threshold")) {
+      string threshold = processor.ValueOf("gc-threshold");
+      size_t value = 0;
+      auto result = from_chars(threshold.data(), threshold.data() + threshold.size(), value);
+
+      if (result.ec != std::errc()) {
+        puts("Invalid collector threshold");
+        return;
+      }
+
+      runtime::SetGcThreshold(value);
+    }
+
+    if (processor.Exist("gc-growth")) {
+      string growth = processor.ValueOf("gc-growth");
+      double value = 0;
+      auto result = from_chars(growth.data(), growth.data() + growth.size(), value);
+
+      if (result.ec != std::errc() || value < 1.0) {
+        puts("Invalid collector growth factor");
+        return;
+      }
+
+      runtime::SetGcGrowth(value);
+    }
+
+    if (processor.Exist("gc-step")) {
+      string step = processor.ValueOf("gc-step");
+      size_t value = 0;
+      auto result = from_chars(step.data(), step.data() + step.size(), value);
+
+      if (result.ec != std::errc()) {
+        puts("Invalid collector step size");
+        return;
+      }
+
+      runtime::SetGcStepBudget(value);
+    }
+
+    runtime::SetGcStatsEnabled(processor.Exist("gc-stats"));
+
     setlocale(LC_ALL, processor.Exist("locale") ?
       processor.ValueOf("locale").data() : "en_US.UTF8");
 
     runtime::InformScriptPath(path);
-    BootMainVMObject(path, log, true);
+
+    if (processor.Exist("emit-cpp")) {
+      EmitNativeScript(path, log, processor.ValueOf("emit-cpp"));
+    }
+    else {
+      BootMainVMObject(path, log, true);
+    }
+
     CloseStream();
   }
   else if (processor.Exist("help")) {
@@ -168,7 +284,15 @@ int main(int argc, char **argv) {
     Pattern("log"    , Option(true, true)),
     Pattern("locale" , Option(true, true)),
     Pattern("vm_stdout" ,Option(true, true)),
-    Pattern("vm_stdin"  ,Option(true, true))
+    Pattern("vm_stdin"  ,Option(true, true)),
+    Pattern("opt"       ,Option(true, true)),
+    Pattern("depth"     ,Option(true, true)),
+    Pattern("emit-cpp"  ,Option(true, true)),
+    Pattern("jit"       ,Option(false, true)),
+    Pattern("gc-threshold" ,Option(true, true)),
+    Pattern("gc-growth"    ,Option(true, true)),
+    Pattern("gc-step"      ,Option(true, true)),
+    Pattern("gc-stats"     ,Option(false, true))
   };
 
   if (argc <= 1) {
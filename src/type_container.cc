@@ -26,7 +26,7 @@ namespace sapphire {
       }
     }
 
-    state.PushValue(Object(base, kTypeIdArray));
+    state.PushValue(Object(base, kTypeHandleArray));
     return 0;
   }
 
@@ -47,12 +47,12 @@ namespace sapphire {
   int Array_GetSize(State &state, ObjectMap &p) {
     auto &obj = p[kStrMe];
     int64_t size = static_cast<int64_t>(obj.Cast<ObjectArray>().size());
-    state.PushValue(Object(size, kTypeIdInt));
+    state.PushValue(Object(size, kTypeHandleInt));
     return 0;
   }
 
   int Array_Empty(State &state, ObjectMap &p) {
-    state.PushValue(Object(p[kStrMe].Cast<ObjectArray>().empty(), kTypeIdBool));
+    state.PushValue(Object(p[kStrMe].Cast<ObjectArray>().empty(), kTypeHandleBool));
     return 0;
   }
 
@@ -66,7 +66,7 @@ namespace sapphire {
   int Array_Pop(State &state, ObjectMap &p) {
     ObjectArray &base = p.Cast<ObjectArray>(kStrMe);
     if (!base.empty()) base.pop_back();
-    state.PushValue(Object(base.empty(), kTypeIdBool));
+    state.PushValue(Object(base.empty(), kTypeHandleBool));
     return 0;
   }
 
@@ -83,7 +83,7 @@ namespace sapphire {
     ManagedPair pair = make_shared<ObjectPair>(
       components::DumpObject(left),
       components::DumpObject(right));
-    state.PushValue(Object(pair, kTypeIdPair));
+    state.PushValue(Object(pair, kTypeHandlePair));
     return 0;
   }
 
@@ -101,7 +101,7 @@ namespace sapphire {
 
   int NewTable(State &state, ObjectMap &p) {
     ManagedTable table = make_shared<ObjectTable>();
-    state.PushValue(Object(table, kTypeIdTable));
+    state.PushValue(Object(table, kTypeHandleTable));
     return 0;
   }
 
@@ -111,7 +111,7 @@ namespace sapphire {
     auto &key = p["key"];
     auto &value = p["value"];
 
-    if (!lexical::IsPlainType(key.GetTypeId())) {
+    if (!IsPlainTypeHandle(key.GetTypeHandle())) {
       state.SetMsg("Invalid key type");
       return 2;
     }
@@ -120,7 +120,7 @@ namespace sapphire {
       make_pair(DumpObject(key), DumpObject(value))
     );
 
-    state.PushValue(Object(result.second, kTypeIdBool));
+    state.PushValue(Object(result.second, kTypeHandleBool));
     return 0;
   }
 
@@ -155,19 +155,19 @@ namespace sapphire {
     auto &table = p.Cast<ObjectTable>(kStrMe);
     auto &key = p["key"];
     auto count = table.erase(key);
-    state.PushValue(Object(static_cast<int64_t>(count), kTypeIdInt));
+    state.PushValue(Object(static_cast<int64_t>(count), kTypeHandleInt));
     return 0;
   }
 
   int Table_Empty(State &state, ObjectMap &p) {
     auto &table = p.Cast<ObjectTable>(kStrMe);
-    state.PushValue(Object(table.empty(), kTypeIdBool));
+    state.PushValue(Object(table.empty(), kTypeHandleBool));
     return 0;
   }
 
   int Table_GetSize(State &state, ObjectMap &p) {
     auto &table = p.Cast<ObjectTable>(kStrMe);
-    state.PushValue(Object(static_cast<int64_t>(table.size()), kTypeIdInt));
+    state.PushValue(Object(static_cast<int64_t>(table.size()), kTypeHandleInt));
     return 0;
   }
 
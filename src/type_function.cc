@@ -3,7 +3,7 @@
 namespace sapphire {
   int Function_GetId(State &state, ObjectMap &p) {
     auto &impl = p.Cast<Function>(kStrMe);
-    state.PushValue(Object(impl.GetId(), kTypeIdString));
+    state.PushValue(Object(impl.GetId(), kTypeHandleString));
     return 0;
   }
 
@@ -13,10 +13,10 @@ namespace sapphire {
     auto origin_vector = impl.AccessParameters();
 
     for (auto it = origin_vector.begin(); it != origin_vector.end(); ++it) {
-      dest_base->emplace_back(Object(*it, kTypeIdString));
+      dest_base->emplace_back(Object(*it, kTypeHandleString));
     }
 
-    state.PushValue(Object(dest_base, kTypeIdArray));
+    state.PushValue(Object(dest_base, kTypeHandleArray));
     return 0;
   }
 
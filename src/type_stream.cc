@@ -4,7 +4,7 @@ namespace sapphire {
   template <typename StreamType>
   int StreamFamilyState(State &state, ObjectMap &p) {
     StreamType &stream = p.Cast<StreamType>(kStrMe);
-    state.PushValue(Object(stream.Good(), kTypeIdBool));
+    state.PushValue(Object(stream.Good(), kTypeHandleBool));
     return 0;
   }
 
@@ -12,7 +12,7 @@ namespace sapphire {
     string path = p.Cast<string>("path");
 
     shared_ptr<InStream> ifs = make_shared<InStream>(path);
-    state.PushValue(Object(ifs, kTypeIdInStream));
+    state.PushValue(Object(ifs, kTypeHandleInStream));
 
     return 0;
   }
@@ -27,13 +27,13 @@ namespace sapphire {
 
     string result = ifs.GetLine();
 
-    state.PushValue(Object(result, kTypeIdString));
+    state.PushValue(Object(result, kTypeHandleString));
     return 0;
   }
 
   int InStream_EOF(State &state, ObjectMap &p) {
     InStream &ifs = p.Cast<InStream>(kStrMe);
-    state.PushValue(Object(ifs.eof(), kTypeIdBool));
+    state.PushValue(Object(ifs.eof(), kTypeHandleBool));
     return 0;
   }
 
@@ -43,7 +43,7 @@ namespace sapphire {
     bool append = p.Cast<bool>("append");
 
     shared_ptr<OutStream> ofs = make_shared<OutStream>(path, append, binary);
-    state.PushValue(Object(ofs, kTypeIdOutStream));
+    state.PushValue(Object(ofs, kTypeHandleOutStream));
     return 0;
   }
 
@@ -52,7 +52,7 @@ namespace sapphire {
     auto &obj = p["str"];
     bool result = true;
 
-    if (obj.GetTypeId() == kTypeIdString) {
+    if (obj.GetTypeHandle() == kTypeHandleString) {
       string str = obj.Cast<string>();
       result = ofs.Write(str);
     }
@@ -60,7 +60,7 @@ namespace sapphire {
       result = false;
     }
 
-    state.PushValue(Object(result, kTypeIdBool));
+    state.PushValue(Object(result, kTypeHandleBool));
     return 0;
   }
 
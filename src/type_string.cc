@@ -14,7 +14,7 @@ namespace sapphire {
 
     auto elem = make_shared<string>();
     elem->append(1, me[index]);
-    state.PushValue(Object(elem, kTypeIdString));
+    state.PushValue(Object(elem, kTypeHandleString));
     return 0;
   }
 
@@ -34,20 +34,20 @@ namespace sapphire {
     }
 
     auto elem = me.substr(begin, size);
-    state.PushValue(Object(elem, kTypeIdString));
+    state.PushValue(Object(elem, kTypeHandleString));
     return 0;
   }
 
   int String_GetSize(State &state, ObjectMap &p) {
     auto &me = p.Cast<string>(kStrMe);
     auto size = static_cast<int64_t>(me.size());
-    state.PushValue(Object(size, kTypeIdInt));
+    state.PushValue(Object(size, kTypeHandleInt));
     return 0;
   }
 
   int String_ToWide(State &state, ObjectMap &p) {
     auto wstr = s2ws(p.Cast<string>(kStrMe));
-    state.PushValue(Object(wstr, kTypeIdWideString));
+    state.PushValue(Object(wstr, kTypeHandleWideString));
     return 0;
   }
 
@@ -55,19 +55,19 @@ namespace sapphire {
     auto &rhs_obj = p[kStrRightHandSide];
     auto &me = p.Cast<string>(kStrMe);
 
-    if (rhs_obj.GetTypeId() != kTypeIdString) {
-      state.PushValue(Object(false, kTypeIdBool));
+    if (rhs_obj.GetTypeHandle() != kTypeHandleString) {
+      state.PushValue(Object(false, kTypeHandleBool));
       return 0;
     }
 
-    state.PushValue(Object(me == rhs_obj.Cast<string>(), kTypeIdBool));
+    state.PushValue(Object(me == rhs_obj.Cast<string>(), kTypeHandleBool));
     return 0;
   }
   
   int NewWideString(State &state, ObjectMap &p) {
     auto &src = p.Cast<string>("src");
     auto me = make_shared<wstring>(s2ws(src));
-    state.PushValue(Object(me, kTypeIdWideString));
+    state.PushValue(Object(me, kTypeHandleWideString));
     return 0;
   }
 
@@ -82,7 +82,7 @@ namespace sapphire {
 
     auto elem = make_shared<wstring>();
     elem->append(1, me[index]);
-    state.PushValue(Object(elem, kTypeIdWideString));
+    state.PushValue(Object(elem, kTypeHandleWideString));
     return 0;
   }
 
@@ -102,20 +102,20 @@ namespace sapphire {
     }
 
     auto elem = me.substr(begin, size);
-    state.PushValue(Object(elem, kTypeIdWideString));
+    state.PushValue(Object(elem, kTypeHandleWideString));
     return 0;
   }
 
   int WString_GetSize(State &state, ObjectMap &p) {
     auto &me = p.Cast<wstring>(kStrMe);
     auto size = static_cast<int64_t>(me.size());
-    state.PushValue(Object(size, kTypeIdInt));
+    state.PushValue(Object(size, kTypeHandleInt));
     return 0;
   }
 
   int WString_ToBytes(State &state, ObjectMap &p) {
     auto str = ws2s(p.Cast<wstring>(kStrMe));
-    state.PushValue(Object(str, kTypeIdString));
+    state.PushValue(Object(str, kTypeHandleString));
     return 0;
   }
 
@@ -123,12 +123,12 @@ namespace sapphire {
     auto &rhs_obj = p[kStrRightHandSide];
     auto &me = p.Cast<wstring>(kStrMe);
 
-    if (rhs_obj.GetTypeId() != kTypeIdWideString) {
-      state.PushValue(Object(false, kTypeIdBool));
+    if (rhs_obj.GetTypeHandle() != kTypeHandleWideString) {
+      state.PushValue(Object(false, kTypeHandleBool));
       return 0;
     }
 
-    state.PushValue(Object(me == rhs_obj.Cast<wstring>(), kTypeIdBool));
+    state.PushValue(Object(me == rhs_obj.Cast<wstring>(), kTypeHandleBool));
     return 0;
   }
 
@@ -165,7 +165,7 @@ namespace sapphire {
     string str = ParseRawString(p["str"].Cast<string>());
 
     int64_t dest = stol(str, nullptr, base);
-    state.PushValue(Object(dest, kTypeIdInt));
+    state.PushValue(Object(dest, kTypeHandleInt));
     return 0;
   }
 
@@ -177,13 +177,13 @@ namespace sapphire {
       return 2;
     }
 
-    state.PushValue(Object(static_cast<int64_t>(value[0]), kTypeIdString));
+    state.PushValue(Object(static_cast<int64_t>(value[0]), kTypeHandleString));
     return 0;
   }
 
   int ConvertIntToChar(State &state, ObjectMap &p) {
     auto value = static_cast<char>(p.Cast<int64_t>("value"));
-    state.PushValue(Object(string().append(1, value), kTypeIdString));
+    state.PushValue(Object(string().append(1, value), kTypeHandleString));
     return 0;
 
   }
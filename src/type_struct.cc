@@ -5,11 +5,11 @@ namespace sapphire {
     auto &struct_def = p.Cast<ObjectStruct>(kStrMe);
     auto managed_array = make_shared<ObjectArray>();
 
-    for (auto &unit : struct_def.GetContent()) {
-      managed_array->push_back(Object(unit.first));
-    }
+    struct_def.ForEach([&](const string &id, Object &) {
+      managed_array->push_back(Object(id));
+    });
 
-    state.PushValue(Object(managed_array, kTypeIdArray));
+    state.PushValue(Object(managed_array, kTypeHandleArray));
     return 0;
   }
 